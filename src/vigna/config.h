@@ -8,6 +8,12 @@
 
 #define VIGNA_SPARSE_PAGE 4096
 #define VIGNA_ENTITY_TYPE uint32_t
+#define VIGNA_DELEGATE_STORAGE (3 * sizeof(void*))
+#define VIGNA_CACHE_LINE 64
+
+#if !defined(VIGNA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   define VIGNA_SSE2
+#endif
 
 #ifndef VIGNA_NO_ETO // empty type optimization
 #   define VIGNA_ETO(x) std::enable_if_t< std::is_empty_v<x> >
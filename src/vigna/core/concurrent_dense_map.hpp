@@ -0,0 +1,182 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+
+#include "dense_map.hpp"
+#include "spin_lock.hpp"
+#include "vigna/config.h"
+
+namespace vigna {
+
+// dense_map split into Shards independently locked maps, keys are spread over them by hash,
+// readers of a shard share its lock and writers take it alone
+template <class Key, class Value, size_t Shards = 16, class Hash = std::hash<Key>, class Eq = std::equal_to<Key>, class Alloc = std::allocator<std::pair<const Key, Value>>>
+class concurrent_dense_map {
+    static_assert(Shards > 0 && Shards <= 0x8000 && (Shards & (Shards - 1)) == 0, "Shard count must be a power of two");
+
+public:
+    using map_type = dense_map<Key, Value, Hash, Eq, Alloc>;
+    using allocator_type = Alloc;
+    using key_type = Key;
+    using mapped_type = Value;
+
+private:
+    struct alignas(VIGNA_CACHE_LINE) shard {
+        mutable shared_spin_lock lock;
+        map_type map;
+    };
+
+    static constexpr size_t shard_bits = detail::countr_zero16(static_cast<uint32_t>(Shards));
+
+    template <class K>
+    [[nodiscard]] size_t shard_of(const K& key) const {
+        if constexpr (Shards == 1) return 0;
+        // the top bits of a multiplicative mix, the shard maps take theirs from the low end
+        auto h = static_cast<uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ull;
+        return static_cast<size_t>(h >> (64 - shard_bits));
+    }
+
+    template <class K>
+    [[nodiscard]] shard& shard_for(const K& key) { return shards_[shard_of(key)]; }
+    template <class K>
+    [[nodiscard]] const shard& shard_for(const K& key) const { return shards_[shard_of(key)]; }
+
+public:
+    concurrent_dense_map() = default;
+    explicit concurrent_dense_map(const Alloc& alloc) {
+        for (auto&& s : shards_) s.map = map_type{alloc};
+    }
+
+    concurrent_dense_map(const concurrent_dense_map&) = delete;
+    concurrent_dense_map& operator=(const concurrent_dense_map&) = delete;
+
+    [[nodiscard]] static constexpr size_t shard_count() { return Shards; }
+
+    // a snapshot, entries may come and go while it is summed
+    [[nodiscard]] size_t size() const {
+        size_t n = 0;
+        for_each_shard([&n](size_t, const map_type& m) { n += m.size(); });
+        return n;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    void reserve(size_t n) {
+        for (auto&& s : shards_) {
+            std::unique_lock lock{s.lock};
+            s.map.reserve(n / Shards + 1);
+        }
+    }
+
+    void clear() {
+        for (auto&& s : shards_) {
+            std::unique_lock lock{s.lock};
+            s.map.clear();
+        }
+    }
+
+    // inserts unless the key is present, returns whether it did
+    template <class...Args>
+    bool emplace(const Key& key, Args&&...args) {
+        auto& s = shard_for(key);
+        std::unique_lock lock{s.lock};
+        if (s.map.contains(key)) return false;
+        s.map.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        return true;
+    }
+
+    // returns whether the key was inserted rather than assigned
+    template <class V>
+    bool insert_or_assign(const Key& key, V&& value) {
+        auto& s = shard_for(key);
+        std::unique_lock lock{s.lock};
+        if (auto it = s.map.find(key); it != s.map.end()) {
+            it->second = std::forward<V>(value);
+            return false;
+        }
+        s.map.emplace(key, std::forward<V>(value));
+        return true;
+    }
+
+    bool erase(const Key& key) {
+        auto& s = shard_for(key);
+        std::unique_lock lock{s.lock};
+        if (auto it = s.map.find(key); it != s.map.end()) {
+            s.map.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    // copies the value out, references would outlive the shard lock
+    template <class K>
+    [[nodiscard]] std::optional<Value> find(const K& key) const {
+        auto& s = shard_for(key);
+        std::shared_lock lock{s.lock};
+        if (auto it = s.map.find(key); it != s.map.end())
+            return it->second;
+        return std::nullopt;
+    }
+
+    template <class K>
+    [[nodiscard]] bool contains(const K& key) const {
+        auto& s = shard_for(key);
+        std::shared_lock lock{s.lock};
+        return s.map.contains(key);
+    }
+
+    // calls fn(const Value&) under the shared shard lock, returns whether the key was found
+    template <class K, class Fn>
+    bool visit(const K& key, Fn&& fn) const {
+        auto& s = shard_for(key);
+        std::shared_lock lock{s.lock};
+        if (auto it = s.map.find(key); it != s.map.end())
+            return std::forward<Fn>(fn)(std::as_const(it->second)), true;
+        return false;
+    }
+
+    // calls fn(Value&) under the unique shard lock, returns whether the key was found
+    template <class K, class Fn>
+    bool modify(const K& key, Fn&& fn) {
+        auto& s = shard_for(key);
+        std::unique_lock lock{s.lock};
+        if (auto it = s.map.find(key); it != s.map.end())
+            return std::forward<Fn>(fn)(it->second), true;
+        return false;
+    }
+
+    // fn(shard index, const map_type&) on each shard in turn, each under its shared lock
+    template <class Fn>
+    void for_each_shard(Fn&& fn) const {
+        for (size_t i = 0; i < Shards; ++i) visit_shard(i, fn);
+    }
+
+    // a single shard, so that parallel scans can hand one to each worker
+    template <class Fn>
+    void visit_shard(size_t i, Fn&& fn) const {
+        assert(i < Shards);
+        std::shared_lock lock{shards_[i].lock};
+        std::forward<Fn>(fn)(i, std::as_const(shards_[i].map));
+    }
+
+    template <class Fn>
+    void modify_shard(size_t i, Fn&& fn) {
+        assert(i < Shards);
+        std::unique_lock lock{shards_[i].lock};
+        std::forward<Fn>(fn)(i, shards_[i].map);
+    }
+
+private:
+    std::array<shard, Shards> shards_;
+    Hash hash_;
+
+};
+
+}
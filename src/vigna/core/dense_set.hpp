@@ -7,12 +7,14 @@
 #include <vector>
 #include <cassert>
 
+#include "flat_index.hpp"
+#include "small_vector.hpp"
 #include "compressed_pair.hpp"
 
 namespace vigna {
 
 namespace detail {
-template <class T, class Deref, class Res = std::invoke_result_t<Deref, typename std::vector<T>::const_iterator>>
+template <class It, class Deref, class Res = std::invoke_result_t<Deref, It>>
 class dense_set_it_warp {
 public:
     using iterator_category = std::random_access_iterator_tag;
@@ -21,7 +23,7 @@ public:
     using pointer = value_type*;
     using reference = value_type&;
 
-    explicit dense_set_it_warp(typename std::vector<T>::const_iterator it) : it_(it) {}
+    explicit dense_set_it_warp(It it) : it_(it) {}
 
     Res operator*() const { static Deref d{}; return d(it_); }
 
@@ -88,25 +90,26 @@ public:
     }
 
 private:
-    typename std::vector<T>::const_iterator it_;
+    It it_;
 };
 } // namespace detail
 
-template <class T, class Hash = std::hash<T>, class Eq = std::equal_to<T>, class Alloc = std::allocator<T>>
+template <class T, class Hash = std::hash<T>, class Eq = std::equal_to<T>, class Alloc = std::allocator<T>, size_t Inline = 0>
 class dense_set {
     static constexpr size_t null_index = SIZE_MAX;
-    static constexpr float hash_k = .707f;
 
     struct node_t {
         template <class...Args>
         explicit node_t(Args&&...args) : value{std::forward<Args>(args)...} {}
         T value;
-        size_t next = null_index;
+        size_t hash{}; // cached, the index and rehash never call the user hash again
     };
 
     using alloc_traits = std::allocator_traits<Alloc>;
-    using sparse_container = std::vector<size_t, typename alloc_traits::template rebind_alloc<size_t>>;
-    using packed_container = std::vector<node_t, typename alloc_traits::template rebind_alloc<node_t>>;
+    using index_type = detail::flat_index<Alloc>;
+    using packed_container = std::conditional_t<Inline == 0,
+        std::vector<node_t, typename alloc_traits::template rebind_alloc<node_t>>,
+        detail::small_vector<node_t, Inline, typename alloc_traits::template rebind_alloc<node_t>>>;
 
     struct node_deref { const T& operator()(const typename packed_container::const_iterator& it) const {
         return it->value;
@@ -115,16 +118,13 @@ class dense_set {
     // [[nodiscard]] auto index_to_iterator(size_t index)  { return begin() + index; }
     [[nodiscard]] auto index_to_iterator(size_t index) const { return cbegin() + index; }
 
-    [[nodiscard]] size_t hash_of(size_t i) const { return sparse_.second()(packed_.first()[i].value); }
-    void set_hash(size_t hash, size_t index) {
-        assert(sparse_.first().size() > 0);
-        hash %= sparse_.first().size();
-        sparse_.first()[hash] = index;
-    }
+    [[nodiscard]] size_t hash_of(size_t i) const { return packed_.first()[i].hash; }
+    [[nodiscard]] auto hash_fn() const { return [this](size_t i) { return hash_of(i); }; }
 
     template <class...Args>
     void emplace_back(Args&&...args) {
-        packed_.first().emplace_back(std::forward<Args>(args)...);
+        auto& node = packed_.first().emplace_back(std::forward<Args>(args)...);
+        node.hash = index_.second()(node.value);
         length_++;
     }
     template <class...Args>
@@ -132,95 +132,68 @@ class dense_set {
         auto* node = &packed_.first()[length_++];
         node->~node_t();
         new (node) node_t(std::forward<Args>(args)...);
+        node->hash = index_.second()(node->value);
     }
 
-    [[nodiscard]] size_t hash_list_back(size_t hash) const {
-        hash %= sparse_.first().size();
-        size_t back = sparse_.first()[hash];
-        if (back != null_index)
-            while (packed_.first()[back].next != null_index)
-                back = packed_.first()[back].next;
-        return back;
-    }
-    [[nodiscard]] size_t hash_list_pre(size_t index) const {
-        auto hash = hash_of(index) % sparse_.first().size();
-        size_t pre = sparse_.first()[hash];
-        if (pre != index)
-            while (packed_.first()[pre].next != index)
-                assert(pre != null_index), pre = packed_.first()[pre].next;
-        return pre;
-    }
-
-    void rehash() {
-        sparse_.first().assign(static_cast<size_t>(length_ * 2 / hash_k), null_index);
-        for (size_t i = 0; i < length_; i++)
-            sparse_emplace(i);
-    }
-
-    // need: false, needn't: true
-    bool rehash_if_need() {
-        if (length_ < sparse_.first().size() * hash_k)
-            return true;
-        rehash();
-        return false;
-    }
+    // up to Inline entries are found by a linear scan, the index is only built past that
+    [[nodiscard]] bool linear() const { return Inline > 0 && index_.first().capacity() == 0; }
 
     void sparse_emplace(size_t id) {
-        auto hs = hash_of(id);
-        if (auto back = hash_list_back(hs); back == null_index) {
-            set_hash(hs, id);
-            packed_.first()[id].next = null_index;
-        } else {
-            packed_.first()[back].next = id;
-        }
-    }
-
-    void isolate(size_t index) {
-        auto pre = hash_list_pre(index);
-        assert(pre != null_index);
-        if (pre == index)
-            set_hash(hash_of(index), packed_.first()[index].next);
-        else
-            packed_.first()[pre].next = packed_.first()[index].next;
-        packed_.first()[index].next = null_index;
+        if (!linear()) index_.first().insert(hash_of(id), id, hash_fn());
+        else if (length_ > Inline) index_.first().rebuild(length_, length_, hash_fn());
     }
 
     void swap_only(size_t index) {
-        isolate(index);
+        if (!linear()) index_.first().erase(hash_of(index), index);
         if (index != --length_) {
-            auto pre = hash_list_pre(length_);
-            assert(pre != null_index);
-            if (pre == length_) set_hash(hash_of(length_), index);
-            else packed_.first()[pre].next = index;
+            if (!linear()) index_.first().relocate(hash_of(length_), length_, index);
             std::swap(packed_.first()[index], packed_.first()[length_]);
         }
     }
 
-    [[nodiscard]] size_t find_index(const T& key) const {
-        if (sparse_.first().empty()) return null_index;
-        auto hs = sparse_.second()(key) % sparse_.first().size();
-        auto i = sparse_.first()[hs];
-        while (i != null_index && !packed_.second()(packed_.first()[i].value, key))
-            i = packed_.first()[i].next;
-        return i;
+    template <class K>
+    [[nodiscard]] size_t find_index(const K& key) const {
+        auto hash = index_.second()(key);
+        auto eq = [&](size_t i) {
+            auto& node = packed_.first()[i];
+            return node.hash == hash && packed_.second()(node.value, key);
+        };
+        if (linear()) {
+            for (size_t i = 0; i < length_; ++i)
+                if (eq(i)) return i;
+            return null_index;
+        }
+        return index_.first().find(hash, eq);
     }
 
+    template <class K>
+    static constexpr bool transparent_v = detail::is_transparent_v<Hash> && detail::is_transparent_v<Eq>;
+
 public:
     using allocator_type = Alloc;
     using value_type = T;
-    using iterator = detail::dense_set_it_warp<node_t, node_deref>;
+    using iterator = detail::dense_set_it_warp<typename packed_container::const_iterator, node_deref>;
     using const_iterator = iterator;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = reverse_iterator;
 
     dense_set() = default;
+    explicit dense_set(const Alloc& alloc)
+        : index_{index_type{alloc}, Hash{}},
+          packed_{packed_container(typename packed_container::allocator_type{alloc}), Eq{}} {}
+
+    [[nodiscard]] allocator_type get_allocator() const { return allocator_type{packed_.first().get_allocator()}; }
 
     [[nodiscard]] size_t size() const { return length_; }
     [[nodiscard]] size_t free_size() const { return packed_.first().size() - length_; }
     [[nodiscard]] bool empty() const { return length_ == 0; }
 
     [[nodiscard]] size_t capacity() const { return packed_.first().capacity(); }
-    void reserve(size_t n) { packed_.first().reserve(n); }
+    void reserve(size_t n) {
+        packed_.first().reserve(n);
+        if (!linear()) index_.first().reserve(n, hash_fn());
+        else if (n > Inline) index_.first().rebuild(length_, n, hash_fn());
+    }
 
     template <class...Args>
     iterator emplace(Args&&...args) {
@@ -231,8 +204,7 @@ public:
             replace_back(std::forward<Args>(args)...);
         }
 
-        if (rehash_if_need())
-            sparse_emplace(index);
+        sparse_emplace(index);
 
         return index_to_iterator(index);
     }
@@ -262,7 +234,7 @@ public:
     void pop_back() { erase(index_to_iterator(length_ - 1)); }
 
     void clear() {
-        std::uninitialized_fill(sparse_.first().begin(), sparse_.first().end(), null_index);
+        index_.first().clear();
         length_ = 0;
     }
 
@@ -273,6 +245,7 @@ public:
     void shrink_to_fit() {
         free_clear();
         packed_.first().shrink_to_fit();
+        if (Inline > 0 && length_ <= Inline) index_.first().reset();
     }
 
     const T& undo_pop() {
@@ -290,7 +263,21 @@ public:
         return i == null_index ? end() : index_to_iterator(i);
     }
 
+    // heterogeneous lookup, when both Hash and Eq declare is_transparent
+    template <class K, class = std::enable_if_t<transparent_v<K>>>
+    [[nodiscard]] iterator find(const K& key) {
+        auto i = find_index(key);
+        return i == null_index ? end() : index_to_iterator(i);
+    }
+    template <class K, class = std::enable_if_t<transparent_v<K>>>
+    [[nodiscard]] const_iterator find(const K& key) const {
+        auto i = find_index(key);
+        return i == null_index ? end() : index_to_iterator(i);
+    }
+
     [[nodiscard]] bool contains(const T& key) const { return find(key) != end(); }
+    template <class K, class = std::enable_if_t<transparent_v<K>>>
+    [[nodiscard]] bool contains(const K& key) const { return find(key) != end(); }
 
     [[nodiscard]] const T& front() const { return packed_.first().front().value; }
     [[nodiscard]] const T& back() const { return packed_.first()[length_ - 1].value; }
@@ -309,9 +296,13 @@ public:
     [[nodiscard]] auto crend() const { return rend(); }
 
 private:
-    compressed_pair<sparse_container, Hash> sparse_;
+    compressed_pair<index_type, Hash> index_;
     compressed_pair<packed_container, Eq>   packed_;
     size_t length_{};
 };
 
+// keeps up to N entries inline, searched linearly, and hashes only once it outgrows them
+template <class T, size_t N = 8, class Hash = std::hash<T>, class Eq = std::equal_to<T>, class Alloc = std::allocator<T>>
+using small_dense_set = dense_set<T, Hash, Eq, Alloc, N>;
+
 } // namespace vigna
@@ -0,0 +1,259 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "vigna/config.h"
+
+#ifdef VIGNA_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace vigna::detail {
+
+constexpr uint32_t countr_zero16(uint32_t mask) {
+    if ((mask & 0xffff) == 0) return 16;
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#else
+    uint32_t n = 0;
+    for (; (mask & 1) == 0; mask >>= 1) ++n;
+    return n;
+#endif
+}
+
+constexpr uint32_t countl_zero16(uint32_t mask) {
+    mask &= 0xffff;
+    if (mask == 0) return 16;
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_clz(mask)) - 16;
+#else
+    uint32_t n = 0;
+    for (; (mask & 0x8000) == 0; mask <<= 1) ++n;
+    return n;
+#endif
+}
+
+template <class T, class = void>
+struct is_transparent : std::false_type {};
+
+template <class T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+template <class T>
+constexpr bool is_transparent_v = is_transparent<T>::value;
+
+// open addressing index over a packed array, in the swiss table layout:
+// one control byte per slot (empty, deleted or 7 bits of the hash) probed
+// a group at a time, and a slot array holding the packed index
+template <class Alloc>
+class flat_index {
+    using ctrl_t = int8_t;
+    static constexpr ctrl_t empty = -128;
+    static constexpr ctrl_t deleted = -2;
+
+    static constexpr size_t group_width = 16;
+
+    using alloc_traits = std::allocator_traits<Alloc>;
+    using ctrl_container = std::vector<ctrl_t, typename alloc_traits::template rebind_alloc<ctrl_t>>;
+    using slot_container = std::vector<size_t, typename alloc_traits::template rebind_alloc<size_t>>;
+
+    class group {
+    public:
+#ifdef VIGNA_SSE2
+        explicit group(const ctrl_t* p) : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+        [[nodiscard]] uint32_t match(ctrl_t h) const {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), ctrl_)));
+        }
+        // empty and deleted are the only values below -1
+        [[nodiscard]] uint32_t match_free() const {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl_)));
+        }
+
+    private:
+        __m128i ctrl_;
+#else
+        explicit group(const ctrl_t* p) { std::memcpy(ctrl_, p, group_width); }
+
+        [[nodiscard]] uint32_t match(ctrl_t h) const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < group_width; ++i)
+                mask |= uint32_t(ctrl_[i] == h) << i;
+            return mask;
+        }
+        [[nodiscard]] uint32_t match_free() const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < group_width; ++i)
+                mask |= uint32_t(ctrl_[i] < -1) << i;
+            return mask;
+        }
+
+    private:
+        ctrl_t ctrl_[group_width];
+#endif
+
+    public:
+        [[nodiscard]] uint32_t match_empty() const { return match(empty); }
+    };
+
+    // std::hash is the identity for integers, so spread it before taking bits from both ends
+    static uint64_t mix(size_t hash) {
+        uint64_t h = hash;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+    static size_t h1(uint64_t h) { return static_cast<size_t>(h >> 7); }
+    static ctrl_t h2(uint64_t h) { return static_cast<ctrl_t>(h & 0x7f); }
+
+    // 7/8 max load
+    static size_t max_load(size_t cap) { return cap - cap / 8; }
+    static size_t capacity_for(size_t n) {
+        size_t cap = group_width;
+        while (max_load(cap) < n) cap <<= 1;
+        return cap;
+    }
+
+    [[nodiscard]] size_t mask() const { return slots_.size() - 1; }
+    [[nodiscard]] group group_at(size_t pos) const { return group{ctrl_.data() + pos}; }
+
+    void set_ctrl(size_t i, ctrl_t h) {
+        ctrl_[i] = h;
+        if (i < group_width) ctrl_[slots_.size() + i] = h; // mirrored, so a group read never wraps
+    }
+
+    // triangular probing over groups visits each of them once, as the capacity is a power of two
+    [[nodiscard]] size_t find_free(uint64_t hash) const {
+        for (size_t pos = h1(hash) & mask(), step = group_width;; pos = (pos + step) & mask(), step += group_width)
+            if (auto m = group_at(pos).match_free()) return (pos + countr_zero16(m)) & mask();
+    }
+
+    [[nodiscard]] size_t find_slot(uint64_t hash, size_t index) const {
+        for (size_t pos = h1(hash) & mask(), step = group_width;; pos = (pos + step) & mask(), step += group_width) {
+            auto g = group_at(pos);
+            for (auto m = g.match(h2(hash)); m; m &= m - 1)
+                if (auto i = (pos + countr_zero16(m)) & mask(); slots_[i] == index) return i;
+            assert(!g.match_empty() && "Index not found");
+        }
+    }
+
+    void place(uint64_t hash, size_t index) {
+        auto i = find_free(hash);
+        growth_left_ -= ctrl_[i] == empty;
+        set_ctrl(i, h2(hash));
+        slots_[i] = index;
+    }
+
+    // indexed entries are always the packed range [0, size)
+    template <class HashOf>
+    void rehash(size_t cap, HashOf&& hash_of) {
+        ctrl_.assign(cap + group_width, empty);
+        slots_.assign(cap, null);
+        growth_left_ = max_load(cap);
+        for (size_t i = 0; i < size_; ++i)
+            place(mix(hash_of(i)), i);
+    }
+
+public:
+    static constexpr size_t null = SIZE_MAX;
+
+    flat_index() = default;
+    explicit flat_index(const Alloc& alloc)
+        : ctrl_(typename ctrl_container::allocator_type{alloc}),
+          slots_(typename slot_container::allocator_type{alloc}) {}
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] size_t capacity() const { return slots_.size(); }
+    // heap bytes of the control bytes and slots
+    [[nodiscard]] size_t memory_size() const {
+        return ctrl_.capacity() * sizeof(ctrl_t) + slots_.capacity() * sizeof(size_t);
+    }
+
+    // packed index of the entry accepted by eq, or null
+    template <class Eq>
+    [[nodiscard]] size_t find(size_t hash, Eq&& eq) const {
+        if (size_ == 0) return null;
+        auto mixed = mix(hash);
+        for (size_t pos = h1(mixed) & mask(), step = group_width;; pos = (pos + step) & mask(), step += group_width) {
+            auto g = group_at(pos);
+            for (auto m = g.match(h2(mixed)); m; m &= m - 1)
+                if (auto i = slots_[(pos + countr_zero16(m)) & mask()]; eq(i)) return i;
+            if (g.match_empty()) return null;
+        }
+    }
+
+    // indexes the entry appended to the packed array at position size()
+    template <class HashOf>
+    void insert(size_t hash, size_t index, HashOf&& hash_of) {
+        assert(index == size_);
+        if (growth_left_ == 0) // drop the tombstones in place when they are the most of the load
+            rehash(size_ * 2 < max_load(capacity()) ? capacity() : capacity_for(size_ + 1), hash_of);
+        place(mix(hash), index);
+        ++size_;
+    }
+
+    // forgets the entry at packed index, the caller moves the last one into its place
+    void erase(size_t hash, size_t index) {
+        auto i = find_slot(mix(hash), index);
+        // a probe only passes a slot when it sits in a full run of a group width,
+        // if no such run goes through it the slot may become empty again
+        auto after = group_at(i).match_empty();
+        auto before = group_at((i - group_width) & mask()).match_empty();
+        bool reuse = countr_zero16(after) + countl_zero16(before) < group_width;
+        set_ctrl(i, reuse ? empty : deleted);
+        growth_left_ += reuse;
+        slots_[i] = null;
+        --size_;
+    }
+
+    // the entry at packed index from moved to to
+    void relocate(size_t hash, size_t from, size_t to) {
+        slots_[find_slot(mix(hash), from)] = to;
+    }
+
+    template <class HashOf>
+    void reserve(size_t n, HashOf&& hash_of) {
+        if (n > max_load(capacity())) rehash(capacity_for(n), hash_of);
+    }
+
+    // indexes the packed range [0, size) from scratch, with room for n entries
+    template <class HashOf>
+    void rebuild(size_t size, size_t n, HashOf&& hash_of) {
+        size_ = size;
+        rehash(capacity_for(std::max(size, n)), hash_of);
+    }
+
+    // drops the whole index and its memory
+    void reset() {
+        ctrl_ = ctrl_container(ctrl_.get_allocator());
+        slots_ = slot_container(slots_.get_allocator());
+        size_ = growth_left_ = 0;
+    }
+
+    void clear() {
+        std::fill(ctrl_.begin(), ctrl_.end(), empty);
+        std::fill(slots_.begin(), slots_.end(), null);
+        growth_left_ = max_load(capacity());
+        size_ = 0;
+    }
+
+private:
+    ctrl_container ctrl_;
+    slot_container slots_;
+    size_t size_{};
+    size_t growth_left_{};
+
+};
+
+}
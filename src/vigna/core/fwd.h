@@ -4,5 +4,11 @@
 
 #pragma once
 
+#include "span.hpp"
 #include "dense_set.hpp"
 #include "dense_map.hpp"
+#include "spin_lock.hpp"
+#include "thread_pool.hpp"
+#include "concurrent_dense_map.hpp"
+#include "mapped_file.hpp"
+#include "mapped_allocator.hpp"
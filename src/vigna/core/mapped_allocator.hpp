@@ -0,0 +1,89 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace vigna {
+
+// allocates from files of its own, created in dir (TMPDIR or /tmp by default) and unlinked at once,
+// so that the kernel pages cold blocks out to them instead of to swap and resident memory follows
+// what is touched; blocks under min_mapped bytes come from the heap, as a file each would cost more
+template <class T>
+class mapped_allocator {
+    template <class>
+    friend class mapped_allocator;
+
+    static size_t page_size() {
+        static const auto size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static size_t mapped_size(size_t n) {
+        return (n * sizeof(T) + page_size() - 1) / page_size() * page_size();
+    }
+
+    const char* directory() const {
+        if (dir_) return dir_;
+        if (const char* env = std::getenv("TMPDIR")) return env;
+        return "/tmp";
+    }
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type; // blocks are told apart by their size alone
+
+    static constexpr size_t min_mapped = 1 << 16;
+
+    mapped_allocator() noexcept = default;
+    explicit mapped_allocator(const char* dir) noexcept : dir_(dir) {}
+    template <class U>
+    mapped_allocator(const mapped_allocator<U>& other) noexcept : dir_(other.dir_) {} // NOLINT(*-explicit-constructor)
+
+    T* allocate(size_t n) {
+        if (n * sizeof(T) < min_mapped)
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+
+        char path[4096];
+        const int len = std::snprintf(path, sizeof(path), "%s/vigna-XXXXXX", directory());
+        if (len <= 0 || static_cast<size_t>(len) >= sizeof(path)) throw std::bad_alloc{};
+        const int fd = ::mkstemp(path);
+        if (fd < 0) throw std::bad_alloc{};
+        ::unlink(path);
+
+        const auto size = mapped_size(n);
+        void* p = ::ftruncate(fd, static_cast<off_t>(size)) == 0
+            ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd); // the mapping keeps the file
+        if (p == MAP_FAILED) throw std::bad_alloc{};
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (n * sizeof(T) < min_mapped)
+            ::operator delete(p, std::align_val_t{alignof(T)});
+        else
+            ::munmap(p, mapped_size(n));
+    }
+
+    template <class U>
+    bool operator==(const mapped_allocator<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const mapped_allocator<U>&) const noexcept { return false; }
+
+private:
+    const char* dir_{};
+
+};
+
+}
@@ -0,0 +1,84 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace vigna {
+
+enum class map_mode {
+    read_only,
+    copy_on_write, // writes stay in the process, the kernel copies the touched pages only
+    shared         // writes go through to the file
+};
+
+// a whole file mapped in memory, failing to open leaves it empty and false
+class mapped_file {
+public:
+    mapped_file() = default;
+    explicit mapped_file(const char* path, map_mode mode = map_mode::copy_on_write) { open(path, mode); }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& o) noexcept
+        : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)), fd_(std::exchange(o.fd_, -1)) {}
+    mapped_file& operator=(mapped_file&& o) noexcept {
+        if (this != &o) {
+            close();
+            data_ = std::exchange(o.data_, nullptr);
+            size_ = std::exchange(o.size_, 0);
+            fd_ = std::exchange(o.fd_, -1);
+        }
+        return *this;
+    }
+
+    ~mapped_file() { close(); }
+
+    bool open(const char* path, map_mode mode = map_mode::copy_on_write) {
+        close();
+        fd_ = ::open(path, mode == map_mode::shared ? O_RDWR : O_RDONLY);
+        if (fd_ < 0) return false;
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0 || st.st_size == 0) return close(), false;
+
+        const int prot = mode == map_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+        const int flags = mode == map_mode::shared ? MAP_SHARED : MAP_PRIVATE;
+        auto* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), prot, flags, fd_, 0);
+        if (p == MAP_FAILED) return close(), false;
+        data_ = static_cast<std::byte*>(p);
+        size_ = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    void close() {
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        data_ = nullptr, size_ = 0, fd_ = -1;
+    }
+
+    // asks the kernel to read ahead, for mappings about to be walked through
+    void prefetch() const {
+        if (data_) ::madvise(data_, size_, MADV_WILLNEED);
+    }
+
+    [[nodiscard]] std::byte* data() const { return data_; }
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool is_open() const { return data_ != nullptr; }
+    explicit operator bool() const { return is_open(); }
+
+private:
+    std::byte* data_{};
+    size_t size_{};
+    int fd_ = -1;
+
+};
+
+}
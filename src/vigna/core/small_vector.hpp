@@ -0,0 +1,144 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <memory>
+#include <cassert>
+#include <utility>
+
+namespace vigna::detail {
+
+// vector keeping the first N elements inside the object, the packed storage of small dense containers
+template <class T, size_t N, class Alloc = std::allocator<T>>
+class small_vector : private Alloc {
+    static_assert(N > 0);
+    using alloc_traits = std::allocator_traits<Alloc>;
+
+    [[nodiscard]] T* inline_data() { return std::launder(reinterpret_cast<T*>(inline_)); }
+
+    void destroy_all() {
+        for (size_t i = 0; i < size_; ++i) alloc_traits::destroy(alloc(), data_ + i);
+        size_ = 0;
+    }
+
+    void release() {
+        destroy_all();
+        if (!is_inline()) alloc_traits::deallocate(alloc(), data_, capacity_);
+        data_ = inline_data(), capacity_ = N;
+    }
+
+    void relocate(size_t cap) {
+        auto* buf = cap <= N ? inline_data() : alloc_traits::allocate(alloc(), cap);
+        if (buf == data_) return;
+        for (size_t i = 0; i < size_; ++i) {
+            alloc_traits::construct(alloc(), buf + i, std::move(data_[i]));
+            alloc_traits::destroy(alloc(), data_ + i);
+        }
+        if (!is_inline()) alloc_traits::deallocate(alloc(), data_, capacity_);
+        data_ = buf, capacity_ = cap <= N ? N : cap;
+    }
+
+    Alloc& alloc() { return *this; }
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_vector() = default;
+    explicit small_vector(const Alloc& alloc) : Alloc(alloc) {}
+
+    small_vector(const small_vector& other)
+        : Alloc(alloc_traits::select_on_container_copy_construction(other.get_allocator())) {
+        reserve(other.size_);
+        for (auto&& i : other) emplace_back(i);
+    }
+
+    small_vector(small_vector&& other) noexcept : Alloc(std::move(other.alloc())) {
+        if (other.is_inline()) {
+            for (auto&& i : other) emplace_back(std::move(i));
+            other.destroy_all();
+        } else {
+            data_ = std::exchange(other.data_, other.inline_data());
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, N);
+        }
+    }
+
+    small_vector& operator=(const small_vector& other) {
+        if (this != &other) {
+            destroy_all();
+            reserve(other.size_);
+            for (auto&& i : other) emplace_back(i);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept {
+        if (this != &other) {
+            release();
+            if (other.is_inline()) {
+                for (auto&& i : other) emplace_back(std::move(i));
+                other.destroy_all();
+            } else {
+                data_ = std::exchange(other.data_, other.inline_data());
+                size_ = std::exchange(other.size_, 0);
+                capacity_ = std::exchange(other.capacity_, N);
+            }
+        }
+        return *this;
+    }
+
+    ~small_vector() { release(); }
+
+    [[nodiscard]] allocator_type get_allocator() const { return *this; }
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+    // no heap block, the elements are in the object itself
+    [[nodiscard]] bool is_inline() const { return data_ == reinterpret_cast<const T*>(inline_); }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+    void reserve(size_t n) { if (n > capacity_) relocate(n); }
+    void shrink_to_fit() { relocate(size_); }
+
+    template <class...Args>
+    T& emplace_back(Args&&...args) {
+        if (size_ == capacity_) relocate(capacity_ * 2);
+        alloc_traits::construct(alloc(), data_ + size_, std::forward<Args>(args)...);
+        return data_[size_++];
+    }
+
+    // only the trailing range, as elements may not be assignable
+    iterator erase(const_iterator first, const_iterator last) {
+        assert(last == end() && "Only the tail can be erased");
+        auto n = static_cast<size_t>(first - begin());
+        while (size_ > n) alloc_traits::destroy(alloc(), data_ + --size_);
+        return end();
+    }
+
+    T& operator[](size_t i) { return assert(i < size_), data_[i]; }
+    const T& operator[](size_t i) const { return assert(i < size_), data_[i]; }
+
+    [[nodiscard]] T& front() { return (*this)[0]; }
+    [[nodiscard]] const T& front() const { return (*this)[0]; }
+
+    [[nodiscard]] iterator begin() { return data_; }
+    [[nodiscard]] iterator end() { return data_ + size_; }
+    [[nodiscard]] const_iterator begin() const { return data_; }
+    [[nodiscard]] const_iterator end() const { return data_ + size_; }
+    [[nodiscard]] const_iterator cbegin() const { return data_; }
+    [[nodiscard]] const_iterator cend() const { return data_ + size_; }
+
+private:
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+    T* data_{inline_data()};
+    size_t size_{};
+    size_t capacity_{N};
+
+};
+
+}
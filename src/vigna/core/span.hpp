@@ -0,0 +1,61 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace vigna {
+
+// non-owning view of a contiguous sequence, a subset of std::span for c++17
+template <class T>
+class span {
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using pointer = T*;
+    using reference = T&;
+    using iterator = T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    constexpr span() = default;
+    constexpr span(T* data, size_t size) : data_(data), size_(size) {}
+    constexpr span(T* first, T* last) : data_(first), size_(static_cast<size_t>(last - first)) {}
+
+    template <class Container, class = std::enable_if_t<
+        std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>>>
+    constexpr span(Container& c) : data_(c.data()), size_(c.size()) {} // NOLINT(*-explicit-constructor)
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    constexpr span(const span<U>& other) : data_(other.data()), size_(other.size()) {} // NOLINT(*-explicit-constructor)
+
+    [[nodiscard]] constexpr T* data() const { return data_; }
+    [[nodiscard]] constexpr size_t size() const { return size_; }
+    [[nodiscard]] constexpr bool empty() const { return size_ == 0; }
+
+    [[nodiscard]] constexpr T& operator[](size_t i) const { return assert(i < size_), data_[i]; }
+    [[nodiscard]] constexpr T& front() const { return (*this)[0]; }
+    [[nodiscard]] constexpr T& back() const { return (*this)[size_ - 1]; }
+
+    [[nodiscard]] constexpr span subspan(size_t offset, size_t count = SIZE_MAX) const {
+        assert(offset <= size_);
+        return {data_ + offset, count < size_ - offset ? count : size_ - offset};
+    }
+
+    [[nodiscard]] constexpr iterator begin() const { return data_; }
+    [[nodiscard]] constexpr iterator end() const { return data_ + size_; }
+    [[nodiscard]] constexpr reverse_iterator rbegin() const { return reverse_iterator{end()}; }
+    [[nodiscard]] constexpr reverse_iterator rend() const { return reverse_iterator{begin()}; }
+
+private:
+    T* data_{};
+    size_t size_{};
+
+};
+
+}
@@ -0,0 +1,65 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <cassert>
+#include <cstdint>
+
+namespace vigna {
+
+// reader-writer spin lock, meets the SharedMutex naming
+class shared_spin_lock {
+    static constexpr int32_t writer = -1;
+    static constexpr int spin_limit = 64;
+
+    static void relax(int& spin) {
+        if (++spin < spin_limit) return;
+        spin = 0, std::this_thread::yield();
+    }
+
+public:
+    shared_spin_lock() = default;
+    shared_spin_lock(const shared_spin_lock&) = delete;
+    shared_spin_lock& operator=(const shared_spin_lock&) = delete;
+
+    bool try_lock() {
+        int32_t expected = 0;
+        return state_.compare_exchange_strong(expected, writer, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void lock() {
+        for (int spin = 0; !try_lock(); relax(spin)) {}
+    }
+
+    void unlock() {
+        assert(state_.load(std::memory_order_relaxed) == writer && "Unlocking a lock not held");
+        state_.store(0, std::memory_order_release);
+    }
+
+    bool try_lock_shared() {
+        auto curr = state_.load(std::memory_order_relaxed);
+        return curr != writer && state_.compare_exchange_strong(curr, curr + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void lock_shared() {
+        for (int spin = 0; !try_lock_shared(); relax(spin)) {}
+    }
+
+    void unlock_shared() {
+        assert(state_.load(std::memory_order_relaxed) > 0 && "Unlocking a lock not shared");
+        state_.fetch_sub(1, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool locked() const { return state_.load(std::memory_order_relaxed) == writer; }
+    [[nodiscard]] bool shared() const { return state_.load(std::memory_order_relaxed) > 0; }
+
+private:
+    std::atomic<int32_t> state_{};
+
+};
+
+}
@@ -0,0 +1,144 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace vigna {
+
+// fixed set of workers for fork-join work, the thread asking for the work takes part in it
+class thread_pool {
+    // indices are claimed one at a time, so whoever comes first does the most;
+    // the first throw keeps the rest from being handed out and is held for the caller
+    struct job {
+        job(size_t n, void* fn, void(*call)(void*, size_t)) : n(n), remaining(n), fn(fn), call(call) {}
+
+        void work() {
+            size_t done = 0;
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n; ++done) {
+                try {
+                    call(fn, i);
+                } catch (...) {
+                    // those nobody claimed yet are counted done here, as nobody ever will
+                    auto claimed = next.exchange(n, std::memory_order_relaxed);
+                    if (claimed < n) done += n - claimed;
+                    std::lock_guard lock{mutex};
+                    if (!error) error = std::current_exception();
+                }
+            }
+            if (done && remaining.fetch_sub(done, std::memory_order_acq_rel) == done) {
+                std::lock_guard lock{mutex};
+                cv.notify_all();
+            }
+        }
+
+        void wait() {
+            std::unique_lock lock{mutex};
+            cv.wait(lock, [this] { return remaining.load(std::memory_order_acquire) == 0; });
+        }
+
+        size_t n;
+        std::atomic<size_t> next{};
+        std::atomic<size_t> remaining;
+        void* fn;
+        void(*call)(void*, size_t);
+        std::exception_ptr error; // under mutex
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    void worker() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock{mutex_};
+                cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    // the calling thread is the last worker
+    static size_t default_workers() {
+        auto n = std::thread::hardware_concurrency();
+        return n > 1 ? n - 1 : 0;
+    }
+
+    explicit thread_pool(size_t workers = default_workers()) {
+        workers_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i)
+            workers_.emplace_back([this] { worker(); });
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto&& i : workers_) i.join();
+    }
+
+    // the pool behind parallel policies that name none
+    static thread_pool& shared() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    [[nodiscard]] size_t size() const { return workers_.size(); }
+
+    // fn(i) for each i in [0, n), returns once all of them have; if one throws, those not started
+    // yet are skipped and the first exception is rethrown here once the running ones are done
+    template <class Fn>
+    void run(size_t n, Fn&& fn) {
+        if (n == 0) return;
+        if (n == 1 || workers_.empty()) {
+            for (size_t i = 0; i < n; ++i) fn(i);
+            return;
+        }
+
+        // helpers may only get to the queue after the work is done, so they share ownership of the job
+        auto state = std::make_shared<job>(n, std::addressof(fn), [](void* f, size_t i) {
+            (*static_cast<std::remove_reference_t<Fn>*>(f))(i);
+        });
+        auto helpers = std::min(n - 1, size());
+        {
+            std::lock_guard lock{mutex_};
+            for (size_t i = 0; i < helpers; ++i)
+                tasks_.emplace_back([state] { state->work(); });
+        }
+        helpers == 1 ? cv_.notify_one() : cv_.notify_all();
+
+        state->work();
+        state->wait();
+        if (state->error) std::rethrow_exception(state->error);
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_{};
+
+};
+
+}
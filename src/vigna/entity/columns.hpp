@@ -0,0 +1,205 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+
+#include "registry.hpp"
+#include "vigna/core/span.hpp"
+
+namespace vigna {
+
+enum class column_type : uint32_t {
+    bytes, // anything else, width bytes as they are in memory
+    boolean,
+    i8, i16, i32, i64,
+    u8, u16, u32, u64,
+    f32, f64
+};
+
+namespace detail {
+
+inline constexpr uint64_t column_magic = 0x4c4f43414e474956u; // "VIGNACOL"
+inline constexpr size_t column_align = 64;
+
+template <class V>
+constexpr column_type column_type_of() {
+    if constexpr (std::is_enum_v<V>) return column_type_of<std::underlying_type_t<V>>();
+    else if constexpr (std::is_same_v<V, bool>) return column_type::boolean;
+    else if constexpr (std::is_integral_v<V>) {
+        constexpr column_type s[]{column_type::i8, column_type::i16, column_type::i32, column_type::i64};
+        constexpr column_type u[]{column_type::u8, column_type::u16, column_type::u32, column_type::u64};
+        constexpr auto i = sizeof(V) == 1 ? 0 : sizeof(V) == 2 ? 1 : sizeof(V) == 4 ? 2 : 3;
+        return std::is_signed_v<V> ? s[i] : u[i];
+    }
+    else if constexpr (std::is_same_v<V, float>) return column_type::f32;
+    else if constexpr (std::is_same_v<V, double>) return column_type::f64;
+    else return column_type::bytes;
+}
+
+// all offsets count from the start of the file, names are not terminated
+struct column_header {
+    uint32_t type;
+    uint32_t width;
+    uint64_t length;
+    uint64_t name;
+    uint64_t name_size;
+    uint64_t data;
+};
+
+template <size_t Width>
+void gather(std::byte* out, const std::byte* in, size_t stride, size_t n) {
+    for (size_t i = 0; i < n; ++i) std::memcpy(out + i * Width, in + i * stride, Width);
+}
+
+}
+
+// one column as it lies in a pool, length values of width bytes each, stride bytes apart;
+// it points into the pool and lasts until the pool is next written
+struct column {
+    std::string_view name;
+    column_type type = column_type::bytes;
+    uint32_t width{};
+    size_t stride{};
+    size_t length{};
+    const std::byte* data{};
+
+    [[nodiscard]] bool contiguous() const { return stride == width; }
+    [[nodiscard]] const std::byte* at(size_t i) const { return data + i * stride; }
+
+    template <class V>
+    [[nodiscard]] const V& get(size_t i) const {
+        assert(sizeof(V) == width && i < length);
+        return *reinterpret_cast<const V*>(at(i));
+    }
+};
+
+// columns over the pools of a registry without copying them, the packed entities of a pool
+// and its payload, whole or one data member at a time; a pool that does not exist yields empty columns
+template <class Registry>
+class basic_column_export {
+    using entity_type = typename Registry::entity_type;
+
+    template <class T>
+    using value_type_of = typename Registry::template storage_for_type<T>::value_type;
+
+    template <class V>
+    static column make(std::string_view name, const V* first, size_t stride, size_t length) {
+        return {name, detail::column_type_of<V>(), static_cast<uint32_t>(sizeof(V)), stride,
+                length, reinterpret_cast<const std::byte*>(first)};
+    }
+
+public:
+    using registry_type = Registry;
+
+    explicit basic_column_export(const Registry& reg) : reg_(&reg) {}
+
+    // the entities of the pool of T, row for row with its payload columns; alive entities by default
+    template <class T = entity_type>
+    [[nodiscard]] column entities(std::string_view name = "entity") const {
+        const auto* pool = reg_->template assure<T>();
+        const size_t size = pool ? pool->size() : 0;
+        return make(name, size ? pool->data() : nullptr, sizeof(entity_type), size);
+    }
+
+    // the payload of T as one column, typed when T is arithmetic and raw bytes otherwise
+    template <class T>
+    [[nodiscard]] column values(std::string_view name) const {
+        static_assert(!std::is_void_v<value_type_of<T>>, "Empty types have no payload");
+        static_assert(std::is_trivially_copyable_v<T>, "Columns are written as raw bytes");
+        const auto* pool = reg_->template assure<T>();
+        const size_t size = pool ? pool->size() : 0;
+        return make(name, size ? std::addressof(*pool->cbegin()) : nullptr, sizeof(T), size);
+    }
+
+    // one data member of T, strided over the payload
+    template <class T, class M>
+    [[nodiscard]] column field(std::string_view name, M T::* member) const {
+        static_assert(!std::is_void_v<value_type_of<T>>, "Empty types have no payload");
+        static_assert(std::is_trivially_copyable_v<T>, "Columns are written as raw bytes");
+        const auto* pool = reg_->template assure<T>();
+        const size_t size = pool ? pool->size() : 0;
+        return make(name, size ? std::addressof((*pool->cbegin()).*member) : nullptr, sizeof(T), size);
+    }
+
+private:
+    const Registry* reg_;
+
+};
+
+// streams columns into a self-describing file: the magic, the number of columns, a header each
+// and their names, then every column packed tight and aligned to 64 bytes, in the byte order of the host;
+// contiguous columns go to the archive as they are, strided ones through a buffer of chunk bytes
+template <class Archive>
+void write_columns(Archive& ar, span<const column> columns, size_t chunk = 1 << 20) {
+    auto aligned = [](uint64_t off) { return (off + detail::column_align - 1) / detail::column_align * detail::column_align; };
+    uint64_t offset = 0;
+    auto put = [&](const void* data, size_t size) {
+        if (size) ar.write(data, size);
+        offset += size;
+    };
+    auto pad = [&] {
+        static constexpr char zeros[detail::column_align]{};
+        put(zeros, aligned(offset) - offset);
+    };
+
+    const uint64_t count = columns.size();
+    std::vector<detail::column_header> headers(columns.size());
+    uint64_t at = sizeof(detail::column_magic) + sizeof(count) + count * sizeof(detail::column_header);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        headers[i].name = at;
+        headers[i].name_size = columns[i].name.size();
+        at += columns[i].name.size();
+    }
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const auto& c = columns[i];
+        auto& h = headers[i];
+        h.type = static_cast<uint32_t>(c.type);
+        h.width = c.width;
+        h.length = c.length;
+        h.data = at = aligned(at);
+        at += c.length * c.width;
+    }
+
+    put(&detail::column_magic, sizeof(detail::column_magic));
+    put(&count, sizeof(count));
+    put(headers.data(), headers.size() * sizeof(detail::column_header));
+    for (auto&& c : columns) put(c.name.data(), c.name.size());
+
+    std::vector<std::byte> buffer;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const auto& c = columns[i];
+        pad();
+        assert(offset == headers[i].data);
+        if (c.contiguous()) {
+            put(c.data, c.length * c.width);
+            continue;
+        }
+
+        const size_t rows = std::max<size_t>(1, chunk / std::max<uint32_t>(1, c.width));
+        buffer.resize(std::min(rows, c.length) * c.width);
+        for (size_t lo = 0; lo < c.length; lo += rows) {
+            const auto n = std::min(rows, c.length - lo);
+            switch (c.width) {
+            case 1: detail::gather<1>(buffer.data(), c.at(lo), c.stride, n); break;
+            case 2: detail::gather<2>(buffer.data(), c.at(lo), c.stride, n); break;
+            case 4: detail::gather<4>(buffer.data(), c.at(lo), c.stride, n); break;
+            case 8: detail::gather<8>(buffer.data(), c.at(lo), c.stride, n); break;
+            default:
+                for (size_t k = 0; k < n; ++k) std::memcpy(buffer.data() + k * c.width, c.at(lo + k), c.width);
+            }
+            put(buffer.data(), n * c.width);
+        }
+    }
+}
+
+}
@@ -0,0 +1,38 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <type_traits>
+
+namespace vigna {
+
+// per component customization point, specialize it to change how a type is stored
+// e.g. template <> struct vigna::component_traits<particle> { static constexpr bool signals = false; };
+// a specialization may also name the allocator of the pool, given the one of the registry rebound to T,
+// e.g. template <class> using allocator_type = vigna::mapped_allocator<telemetry>;
+template <class T, class = void>
+struct component_traits {
+    using type = T;
+    static constexpr bool signals = true; // wrap the storage in the signal mixin
+};
+
+namespace detail {
+
+template <class T, class Alloc, class = void>
+struct component_allocator {
+    using type = Alloc;
+};
+
+template <class T, class Alloc>
+struct component_allocator<T, Alloc, std::void_t<typename component_traits<T>::template allocator_type<Alloc>>> {
+    using type = typename component_traits<T>::template allocator_type<Alloc>;
+};
+
+template <class T, class Alloc>
+using component_allocator_t = typename component_allocator<T, Alloc>::type;
+
+}
+
+}
@@ -0,0 +1,425 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "registry.hpp"
+#include "vigna/core/dense_map.hpp"
+#include "vigna/signal/delegate.hpp"
+
+namespace vigna {
+
+namespace detail {
+
+template <class Buffer>
+void put_varint(Buffer& out, uint64_t value) {
+    for (; value >= 0x80; value >>= 7)
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+[[noreturn]] inline void corrupt_delta() {
+    throw std::runtime_error("basic_delta_loader: corrupt delta");
+}
+
+inline uint64_t get_varint(const unsigned char*& in, const unsigned char* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && in != end; shift += 7) {
+        auto b = *in++;
+        value |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return value;
+    }
+    corrupt_delta();
+}
+
+inline void get_bytes(const unsigned char*& in, const unsigned char* end, void* value, size_t size) {
+    if (static_cast<size_t>(end - in) < size) corrupt_delta();
+    std::memcpy(value, in, size);
+    in += size;
+}
+
+// value xor base as alternating runs, the length of the unchanged bytes then of the changed ones
+// followed by the changed bytes xor'ed, so a patched field costs little more than its own size
+template <class Buffer>
+void put_xor(Buffer& out, const unsigned char* value, const unsigned char* base, size_t size) {
+    for (size_t i = 0; i < size;) {
+        auto same = i;
+        while (same < size && value[same] == base[same]) ++same;
+        auto diff = same;
+        while (diff < size && value[diff] != base[diff]) ++diff;
+        put_varint(out, same - i);
+        put_varint(out, diff - same);
+        for (auto k = same; k < diff; ++k) out.push_back(value[k] ^ base[k]);
+        i = diff;
+    }
+}
+
+inline void get_xor(const unsigned char*& in, const unsigned char* end, unsigned char* value, size_t size) {
+    for (size_t i = 0; i < size;) {
+        const auto same = get_varint(in, end);
+        if (same > size - i) corrupt_delta();
+        i += same;
+        const auto diff = get_varint(in, end);
+        if (diff > size - i || diff > static_cast<size_t>(end - in)) corrupt_delta();
+        for (auto n = diff; n != 0; --n) value[i++] ^= *in++;
+    }
+}
+
+struct null_archive {
+    void write(const void*, size_t) {}
+    template <class T>
+    void operator()(const T&) {}
+};
+
+}
+
+// records what happens to a registry through its signals, and writes it as a delta against
+// the state it was in when the recorder was built or last wrote, for the pools of Type...
+//
+// entity ids are varints xor'ed with the previous one, payloads of trivially copyable
+// components are xor'ed with a shadow copy of their value at the reference point,
+// others go through archive(value) whole
+//
+// writes through references, from get or each, fire no on_update: those to trivially copyable components
+// are found by comparing the pool with the shadow copy on every write or mark, which walks the whole pool;
+// those to other components are NOT recorded, go through patch or replace for them
+template <class Registry, class...Type>
+class basic_delta_recorder {
+    using entity_type = typename Registry::entity_type;
+    using traits = entity_traits<entity_type>;
+    using alloc_traits = std::allocator_traits<typename Registry::allocator_type>;
+    using buffer_type = std::vector<unsigned char, typename alloc_traits::template rebind_alloc<unsigned char>>;
+    using entity_container = std::vector<entity_type, typename Registry::allocator_type>;
+
+    template <class Storage>
+    static bool holds(const Storage& pool, const entity_type& entity) {
+        return pool.contains(entity) && pool.data()[pool.index(entity)] == entity;
+    }
+
+    static void put_entities(buffer_type& buf, const entity_container& entities) {
+        detail::put_varint(buf, entities.size());
+        uint64_t prev = 0;
+        for (auto&& e : entities)
+            detail::put_varint(buf, traits::value(e) ^ prev), prev = traits::value(e);
+    }
+
+    template <class Archive>
+    static void put_section(Archive& ar, uint64_t hash, const buffer_type& buf) {
+        const uint64_t size = buf.size();
+        ar.write(&hash, sizeof(hash));
+        ar.write(&size, sizeof(size));
+        ar.write(buf.data(), buf.size());
+    }
+
+    template <class T>
+    class pool_delta {
+        using storage_type = typename Registry::template storage_for_type<T>;
+        static constexpr bool has_payload = !std::is_void_v<typename storage_type::value_type>;
+        static constexpr bool bitwise = has_payload && std::is_trivially_copyable_v<T>;
+
+        static constexpr size_t scan_rows = 64;
+
+        void touch(Registry&, const entity_type entity) { dirty_[traits::id(entity)] = entity; }
+
+        // writes through references from get or each fire no on_update, so the payloads are compared with
+        // the shadow: a block at a time while both hold the same entities in the same order, else row by row
+        template <class Pool>
+        void catch_silent_writes(const Pool& pool) {
+            const auto n = pool.size(), common = std::min(n, shadow_.size());
+            const auto* live = pool.data();
+            const auto* base = shadow_.data();
+            const T* values = n ? std::addressof(*pool.cbegin()) : nullptr;
+            const T* old = shadow_.size() ? std::addressof(*shadow_.cbegin()) : nullptr;
+            auto differs = [](const T* a, const T* b, size_t count) { return std::memcmp(a, b, count * sizeof(T)) != 0; };
+
+            for (size_t lo = 0; lo < n; lo += scan_rows) {
+                const auto hi = std::min(n, lo + scan_rows);
+                if (hi <= common && std::equal(live + lo, live + hi, base + lo) && !differs(values + lo, old + lo, hi - lo))
+                    continue;
+                for (auto i = lo; i < hi; ++i) {
+                    const auto e = live[i];
+                    if (i < common && base[i] == e) {
+                        if (differs(values + i, old + i, 1)) dirty_[traits::id(e)] = e;
+                    } else if (holds(shadow_, e) && differs(values + i, std::addressof(shadow_.get(e)), 1)) {
+                        dirty_[traits::id(e)] = e;
+                    } // not in the shadow, on_construct had it
+                }
+            }
+        }
+
+    public:
+        void bind(Registry& reg) {
+            reg_ = &reg;
+            connections_[0] = reg.template on_construct<T>().template connect<&pool_delta::touch>(this);
+            connections_[1] = reg.template on_destroy<T>().template connect<&pool_delta::touch>(this);
+            connections_[2] = reg.template on_update<T>().template connect<&pool_delta::touch>(this);
+            if constexpr (bitwise) {
+                const auto& pool = *std::as_const(reg).template assure<T>();
+                shadow_.assign(pool.data(), pool.data() + pool.size(), pool.cbegin());
+            }
+        }
+
+        void release() {
+            for (auto&& i : connections_) i.release();
+        }
+
+        // writes the section when given an archive, and moves the reference point either way
+        template <class Archive>
+        void flush(Archive& ar, buffer_type& buf, bool emit) {
+            const auto& pool = *std::as_const(*reg_).template assure<T>();
+            if constexpr (bitwise) catch_silent_writes(pool);
+            entity_container removed{reg_->get_allocator()}, upserted{reg_->get_allocator()};
+            // by id, as a signal may carry a stale version of an entity whose id was recycled
+            for (auto&& [id, e] : dirty_)
+                if (pool.contains(e)) upserted.push_back(pool.data()[pool.index(e)]);
+                else removed.push_back(e);
+            std::sort(removed.begin(), removed.end());
+            std::sort(upserted.begin(), upserted.end());
+
+            if (emit) {
+                buf.clear();
+                put_entities(buf, removed);
+                detail::put_varint(buf, upserted.size());
+                uint64_t prev = 0;
+                for (auto&& e : upserted) {
+                    bool based = false;
+                    if constexpr (bitwise) based = holds(shadow_, e);
+                    detail::put_varint(buf, ((traits::value(e) ^ prev) << 1) | based);
+                    prev = traits::value(e);
+                    if constexpr (bitwise) {
+                        auto* value = reinterpret_cast<const unsigned char*>(std::addressof(pool.get(e)));
+                        if (based) detail::put_xor(buf, value, reinterpret_cast<const unsigned char*>(std::addressof(shadow_.get(e))), sizeof(T));
+                        else buf.insert(buf.end(), value, value + sizeof(T));
+                    }
+                }
+                put_section(ar, Registry::template type_hash<T>(), buf);
+                if constexpr (has_payload && !bitwise)
+                    for (auto&& e : upserted) ar(pool.get(e));
+            }
+
+            if constexpr (bitwise) {
+                for (auto&& e : removed) shadow_.pop(e);
+                for (auto&& e : upserted) {
+                    if (holds(shadow_, e)) shadow_.get(e) = pool.get(e);
+                    else shadow_.pop(e), shadow_.emplace(e, pool.get(e));
+                }
+            }
+            dirty_.clear();
+        }
+
+    private:
+        Registry* reg_{};
+        dense_map<typename traits::id_type, entity_type> dirty_;
+        basic_storage<entity_type, T, typename alloc_traits::template rebind_alloc<T>> shadow_;
+        connection connections_[3];
+    };
+
+    void created(Registry&, const entity_type entity) { log_.emplace_back(entity, false); }
+    void destroyed(Registry&, const entity_type entity) { log_.emplace_back(entity, true); }
+
+    template <class Archive>
+    void flush(Archive& ar, bool emit) {
+        if (emit) {
+            buffer_.clear();
+            detail::put_varint(buffer_, log_.size());
+            uint64_t prev = 0;
+            for (auto&& [e, dead] : log_)
+                detail::put_varint(buffer_, ((traits::value(e) ^ prev) << 1) | dead), prev = traits::value(e);
+            put_section(ar, Registry::template type_hash<entity_type>(), buffer_);
+        }
+        log_.clear();
+        std::apply([&](auto&...pool) { (pool.flush(ar, buffer_, emit), ...); }, pools_);
+    }
+
+public:
+    using registry_type = Registry;
+
+    explicit basic_delta_recorder(Registry& reg) : reg_(&reg), log_(reg.get_allocator()), buffer_(reg.get_allocator()) {
+        create_ = reg.template on_construct<entity_type>().template connect<&basic_delta_recorder::created>(this);
+        destroy_ = reg.template on_destroy<entity_type>().template connect<&basic_delta_recorder::destroyed>(this);
+        std::apply([&](auto&...pool) { (pool.bind(reg), ...); }, pools_);
+    }
+
+    basic_delta_recorder(const basic_delta_recorder&) = delete;
+    basic_delta_recorder& operator=(const basic_delta_recorder&) = delete;
+
+    ~basic_delta_recorder() {
+        create_.release();
+        destroy_.release();
+        std::apply([](auto&...pool) { (pool.release(), ...); }, pools_);
+    }
+
+    // writes everything since the reference point, which then moves to now
+    template <class Archive>
+    void write(Archive& ar) { flush(ar, true); }
+
+    // moves the reference point to now and forgets what happened since the last one
+    void mark() {
+        detail::null_archive ar;
+        flush(ar, false);
+    }
+
+private:
+    Registry* reg_;
+    std::vector<std::pair<entity_type, bool>, typename alloc_traits::template rebind_alloc<std::pair<entity_type, bool>>> log_;
+    buffer_type buffer_;
+    std::tuple<pool_delta<Type>...> pools_;
+    connection create_;
+    connection destroy_;
+
+};
+
+// replays a delta on a registry in the state the recorder was referring to,
+// the types have to be those of the recorder, in the same order
+//
+// throws std::runtime_error on a section of another type, one that does not decode or entities that do not
+// fit the registry, and lets through what the archive throws; sections are applied as they are read,
+// those before the bad one stay applied
+template <class Registry>
+class basic_delta_loader {
+    using entity_type = typename Registry::entity_type;
+    using traits = entity_traits<entity_type>;
+    using alloc_traits = std::allocator_traits<typename Registry::allocator_type>;
+    using buffer_type = std::vector<unsigned char, typename alloc_traits::template rebind_alloc<unsigned char>>;
+    using entity_container = std::vector<entity_type, typename Registry::allocator_type>;
+
+    static constexpr size_t chunk_size = 1 << 20;
+
+    // in chunks, so that a size out of a corrupt archive fails on the read before it is allocated whole
+    template <class Archive>
+    void read_section(uint64_t expected, Archive& ar) {
+        uint64_t hash, size;
+        ar.read(&hash, sizeof(hash));
+        if (hash != expected) throw std::runtime_error("basic_delta_loader: delta read with other types");
+        ar.read(&size, sizeof(size));
+        buffer_.clear();
+        for (uint64_t done = 0; done < size;) {
+            const auto n = static_cast<size_t>(std::min<uint64_t>(size - done, chunk_size));
+            buffer_.resize(static_cast<size_t>(done) + n);
+            ar.read(buffer_.data() + done, n);
+            done += n;
+        }
+    }
+
+    [[nodiscard]] const unsigned char* end() const { return buffer_.data() + buffer_.size(); }
+
+    // ids are handed out in order, a hint may reuse one or take the next
+    [[nodiscard]] bool creatable(const entity_type& entity) const {
+        const auto& pool = *std::as_const(*reg_).template assure<entity_type>();
+        return traits::id(entity) <= pool.size() + pool.cemetery_size();
+    }
+
+    uint64_t varint(const unsigned char*& in) const { return detail::get_varint(in, end()); }
+
+    // a count of things that take a byte at least each, so a corrupt one is caught before it is allocated
+    uint64_t count(const unsigned char*& in) const {
+        const auto n = varint(in);
+        if (n > static_cast<uint64_t>(end() - in)) detail::corrupt_delta();
+        return n;
+    }
+
+    entity_type next_entity(const unsigned char*& in, uint64_t& prev, uint64_t& flag) const {
+        auto v = varint(in);
+        flag = v & 1;
+        prev ^= v >> 1;
+        return traits::construct(static_cast<typename traits::value_type>(prev));
+    }
+
+    template <class T, class Archive>
+    void apply_pool(Archive& ar) {
+        using storage_type = typename Registry::template storage_for_type<T>;
+        constexpr bool has_payload = !std::is_void_v<typename storage_type::value_type>;
+        constexpr bool bitwise = has_payload && std::is_trivially_copyable_v<T>;
+
+        read_section(Registry::template type_hash<T>(), ar);
+        const auto* in = buffer_.data();
+        auto& pool = reg_->template assure<T>();
+
+        entity_container entities{reg_->get_allocator()};
+        entities.resize(count(in));
+        for (uint64_t i = 0, prev = 0; i < entities.size(); ++i)
+            entities[i] = traits::construct(static_cast<typename traits::value_type>(prev ^= varint(in)));
+        if (!entities.empty())
+            pool.pop(entities.cbegin(), entities.cend());
+
+        // values already there are patched in place, new ones are inserted together at the end
+        const auto upserts = count(in);
+        entities.clear();
+        if constexpr (bitwise) {
+            using value_alloc_traits = typename alloc_traits::template rebind_traits<T>;
+            typename value_alloc_traits::allocator_type alloc{reg_->get_allocator()};
+            auto release = [&](T* p) { value_alloc_traits::deallocate(alloc, p, upserts); };
+            std::unique_ptr<T, decltype(release)> values{upserts ? value_alloc_traits::allocate(alloc, upserts) : nullptr, release};
+            for (uint64_t i = 0, prev = 0, based; i < upserts; ++i) {
+                auto e = next_entity(in, prev, based);
+                if (based) {
+                    pool.patch(e, [&](auto&& v) { detail::get_xor(in, end(), reinterpret_cast<unsigned char*>(std::addressof(v)), sizeof(T)); });
+                } else if (pool.contains(e)) {
+                    pool.patch(e, [&](auto&& v) { detail::get_bytes(in, end(), std::addressof(v), sizeof(T)); });
+                } else {
+                    detail::get_bytes(in, end(), values.get() + entities.size(), sizeof(T));
+                    entities.push_back(e);
+                }
+            }
+            if (!entities.empty())
+                pool.insert(entities.cbegin(), entities.cend(), std::make_move_iterator(values.get()));
+        } else {
+            entity_container upserted{reg_->get_allocator()};
+            for (uint64_t i = 0, prev = 0, based; i < upserts; ++i)
+                upserted.push_back(next_entity(in, prev, based));
+            if constexpr (has_payload) {
+                std::vector<T, typename alloc_traits::template rebind_alloc<T>> values(reg_->get_allocator());
+                for (auto&& e : upserted) {
+                    T value{};
+                    ar(value);
+                    if (pool.contains(e)) pool.patch(e, [&](auto&& v) { v = std::move(value); });
+                    else entities.push_back(e), values.push_back(std::move(value));
+                }
+                if (!entities.empty())
+                    pool.insert(entities.cbegin(), entities.cend(), std::make_move_iterator(values.begin()));
+            } else {
+                std::copy_if(upserted.begin(), upserted.end(), std::back_inserter(entities), [&](auto&& e) { return !pool.contains(e); });
+                if (!entities.empty())
+                    pool.insert(entities.cbegin(), entities.cend());
+            }
+        }
+    }
+
+public:
+    using registry_type = Registry;
+
+    explicit basic_delta_loader(Registry& reg) : reg_(&reg), buffer_(reg.get_allocator()) {}
+
+    template <class...Type, class Archive>
+    basic_delta_loader& apply(Archive& ar) {
+        read_section(Registry::template type_hash<entity_type>(), ar);
+        const auto* in = buffer_.data();
+        for (uint64_t n = count(in), prev = 0, dead; n != 0; --n) {
+            auto e = next_entity(in, prev, dead);
+            if (dead ? !reg_->valid(e) : (!creatable(e) || reg_->create(e) != e))
+                throw std::runtime_error("basic_delta_loader: delta applied to another state");
+            if (dead) reg_->destroy(e);
+        }
+        (apply_pool<Type>(ar), ...);
+        return *this;
+    }
+
+private:
+    Registry* reg_;
+    buffer_type buffer_;
+
+};
+
+}
@@ -5,6 +5,13 @@
 #pragma once
 
 #include "entity.hpp"
+#include "component.hpp"
+#include "guard.hpp"
 #include "sparse_set.hpp"
 #include "storage.hpp"
-#include "registry.hpp"
\ No newline at end of file
+#include "registry.hpp"
+#include "snapshot.hpp"
+#include "delta.hpp"
+#include "mapped.hpp"
+#include "rollback.hpp"
+#include "columns.hpp"
\ No newline at end of file
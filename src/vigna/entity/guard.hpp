@@ -0,0 +1,186 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+#include "vigna/config.h"
+#include "vigna/core/spin_lock.hpp"
+
+namespace vigna {
+
+#ifdef VIGNA_POOL_GUARD
+
+// reader-writer guard of a single pool
+class pool_guard : public shared_spin_lock {
+public:
+    pool_guard() = default;
+    pool_guard(pool_guard&&) noexcept : shared_spin_lock() {} // guards are never transferred
+    pool_guard& operator=(pool_guard&&) noexcept { return *this; }
+};
+
+#else
+
+class pool_guard {
+public:
+    static constexpr bool try_lock() { return true; }
+    static constexpr void lock() {}
+    static constexpr void unlock() {}
+    static constexpr bool try_lock_shared() { return true; }
+    static constexpr void lock_shared() {}
+    static constexpr void unlock_shared() {}
+
+    [[nodiscard]] static constexpr bool locked() { return false; }
+    [[nodiscard]] static constexpr bool shared() { return false; }
+};
+
+#endif
+
+#if defined(VIGNA_POOL_GUARD) && !defined(NDEBUG)
+#   define VIGNA_ASSERT_WRITABLE(guard) assert(!(guard).shared() && "Pool mutated while guarded for reading")
+#else
+#   define VIGNA_ASSERT_WRITABLE(guard) ((void)0)
+#endif
+
+#if defined(VIGNA_TRACK_ACCESS) && !defined(NDEBUG)
+
+// debug check of the pools that systems share without locking them, views do not lock on their own:
+// every call that changes the structure of a pool (sparse and packed arrays) counts as its writer while
+// it runs, every lookup of an entity as a reader, and a writer meeting a reader or another writer of
+// another thread asserts. writes to payloads through references are not counted, parallel loops writing their
+// own rows are fine; it catches races while they happen, not every one that could
+class access_tracker {
+    template <bool Write>
+    class scope {
+    public:
+        explicit scope(const access_tracker* tracker) : tracker_(tracker) {}
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+        ~scope() { Write ? tracker_->leave_write() : tracker_->leave_read(); }
+
+    private:
+        const access_tracker* tracker_;
+    };
+
+    void leave_write() const {
+        if (--depth_ == 0) writer_.store(std::thread::id{});
+    }
+
+    void leave_read() const { readers_.fetch_sub(1); }
+
+public:
+    access_tracker() = default;
+    access_tracker(access_tracker&&) noexcept {} // counts stay with the pool they were taken on
+    access_tracker& operator=(access_tracker&&) noexcept { return *this; }
+
+    [[nodiscard]] scope<true> write() const {
+        const auto me = std::this_thread::get_id();
+        if (writer_.load() != me) {
+            auto none = std::thread::id{};
+            [[maybe_unused]] const bool alone = writer_.compare_exchange_strong(none, me);
+            assert(alone && "Pool changed by two threads at once, lock() the views of both systems");
+            assert(readers_.load() == 0 && "Pool changed while another thread reads it, lock() the views of both systems");
+        }
+        ++depth_;
+        return scope<true>{this};
+    }
+
+    [[nodiscard]] scope<false> read() const {
+        readers_.fetch_add(1);
+        [[maybe_unused]] const auto writer = writer_.load();
+        assert((writer == std::thread::id{} || writer == std::this_thread::get_id()) &&
+               "Pool read while another thread changes it, lock() the views of both systems");
+        return scope<false>{this};
+    }
+
+private:
+    mutable std::atomic<std::thread::id> writer_{};
+    mutable std::atomic<uint32_t> readers_{};
+    mutable uint32_t depth_{}; // nested writes of the writer
+};
+
+#else
+
+class access_tracker {
+    struct scope {
+        ~scope() {} // not trivial, so that scopes held for their lifetime draw no unused warning
+    };
+
+public:
+    [[nodiscard]] static scope write() { return {}; }
+    [[nodiscard]] static scope read() { return {}; }
+};
+
+#endif
+
+// locks a group of pools in address order, so that two locks never deadlock;
+// the guards are those of the pools as they are now, and the first write through the registry to a pool
+// a registry snapshot holds copies it, see basic_registry::snapshot: the copy comes with a guard of its own,
+// unlocked, while this lock keeps the one of the pool the snapshot reads. lock after taking snapshots,
+// or take the pools and the lock again after a write that may copy
+template <size_t N>
+class basic_pool_lock {
+    struct entry {
+        pool_guard* guard;
+        bool unique;
+    };
+
+public:
+    basic_pool_lock() = default;
+    basic_pool_lock(const std::array<pool_guard*, N>& guards, const std::array<bool, N>& unique) {
+        for (size_t i = 0; i < N; ++i)
+            if (guards[i] != nullptr) entries_[size_++] = {guards[i], unique[i]};
+        std::sort(entries_.begin(), entries_.begin() + size_, [](auto&& a, auto&& b) {
+            return std::less<>{}(a.guard, b.guard);
+        });
+        size_t n = 0; // a pool appearing twice is locked once, unique if any of them is
+        for (size_t i = 0; i < size_; ++i) {
+            if (n > 0 && entries_[n - 1].guard == entries_[i].guard)
+                entries_[n - 1].unique |= entries_[i].unique;
+            else entries_[n++] = entries_[i];
+        }
+        size_ = n;
+        for (size_t i = 0; i < size_; ++i)
+            entries_[i].unique ? entries_[i].guard->lock() : entries_[i].guard->lock_shared();
+    }
+
+    basic_pool_lock(const basic_pool_lock&) = delete;
+    basic_pool_lock(basic_pool_lock&& other) noexcept
+        : entries_(other.entries_), size_(std::exchange(other.size_, 0)) {}
+    basic_pool_lock& operator=(const basic_pool_lock&) = delete;
+    basic_pool_lock& operator=(basic_pool_lock&& other) noexcept {
+        if (this != &other) {
+            unlock();
+            entries_ = other.entries_;
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    ~basic_pool_lock() { unlock(); }
+
+    void unlock() {
+        while (size_ > 0) {
+            auto& e = entries_[--size_];
+            e.unique ? e.guard->unlock() : e.guard->unlock_shared();
+        }
+    }
+
+    [[nodiscard]] bool owns_lock() const { return size_ > 0; }
+
+private:
+    std::array<entry, N> entries_{};
+    size_t size_{};
+
+};
+
+}
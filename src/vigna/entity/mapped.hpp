@@ -0,0 +1,411 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "registry.hpp"
+#include "vigna/core/dense_map.hpp"
+#include "vigna/core/mapped_file.hpp"
+
+namespace vigna {
+
+namespace detail {
+
+inline constexpr uint64_t mapped_magic = 0x50414d414e474956u; // "VIGNAMAP"
+inline constexpr size_t mapped_align = VIGNA_CACHE_LINE;
+
+// every offset counts from the start of the file, pages of the sparse table that hold
+// no entity have offset 0 and are not written
+struct mapped_section {
+    uint64_t hash;
+    uint64_t size;
+    uint64_t alive; // entity pool only, the rest are dead
+    uint64_t pages;
+    uint64_t packed;
+    uint64_t sparse;
+    uint64_t payload;
+    uint64_t next;
+};
+
+}
+
+// a pool served from a mapping, its packed entities, sparse pages and payload are those of the file;
+// lookups follow basic_sparse_set, payloads are writable when the file is mapped copy on write
+template <class Entity, class T>
+class basic_mapped_pool {
+    using traits = entity_traits<Entity>;
+    using entity_value = typename traits::value_type;
+    static constexpr bool has_payload = !std::is_void_v<T>;
+    using payload_type = std::conditional_t<has_payload, T, char>;
+
+public:
+    using entity_type = Entity;
+    using element_type = T;
+    using value_type = T;
+    using iterator = payload_type*;
+    using const_iterator = const payload_type*;
+    using each_iterator = storage_iterator<Entity, payload_type>;
+
+    basic_mapped_pool() = default;
+    basic_mapped_pool(std::byte* base, const detail::mapped_section& section)
+        : base_(base), packed_(reinterpret_cast<const Entity*>(base + section.packed)),
+          sparse_(reinterpret_cast<const uint64_t*>(base + section.sparse)),
+          payload_(reinterpret_cast<payload_type*>(base + section.payload)),
+          size_(section.size), pages_(section.pages) {}
+
+    [[nodiscard]] size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+    // an index past the packed array, which only a bad file holds, is taken for none
+    [[nodiscard]] entity_value find_index(const Entity& entity) const {
+        const auto id = traits::id(entity);
+        const auto i = id / VIGNA_SPARSE_PAGE, j = id % VIGNA_SPARSE_PAGE;
+        if (i >= pages_ || !sparse_[i]) return null;
+        const auto index = reinterpret_cast<const entity_value*>(base_ + sparse_[i])[j];
+        return index < size_ ? index : static_cast<entity_value>(null);
+    }
+
+    [[nodiscard]] bool contains(const Entity& entity) const { return find_index(entity) != null; }
+    [[nodiscard]] size_t index(const Entity& entity) const { return find_index(entity); }
+
+    [[nodiscard]] const Entity* data() const { return packed_; }
+    const Entity& operator[](size_t i) const { return packed_[i]; }
+
+    template <class U = T, class = std::enable_if_t<!std::is_void_v<U>>>
+    U& get(const Entity& entity) const {
+        assert(contains(entity));
+        return payload_[index(entity)];
+    }
+
+    iterator begin() const { return payload_; }
+    iterator end() const { return payload_ + (has_payload ? size_ : 0); }
+
+    template <class U = T, class = std::enable_if_t<!std::is_void_v<U>>>
+    auto each() const {
+        const auto n = static_cast<std::ptrdiff_t>(size_);
+        return range::subrange{each_iterator{packed_, payload_, 0}, each_iterator{packed_, payload_, n}};
+    }
+
+private:
+    std::byte* base_{};
+    const Entity* packed_{};
+    const uint64_t* sparse_{};
+    payload_type* payload_{};
+    size_t size_{};
+    size_t pages_{};
+
+};
+
+// writes the pools in a layout that can be mapped and used as it is, arrays aligned to a cache line,
+// sparse pages included; the archive has to start at the beginning of the file
+template <class Registry>
+class basic_mapped_snapshot {
+    using entity_type = typename Registry::entity_type;
+    using traits = entity_traits<entity_type>;
+    using entity_value = typename traits::value_type;
+    using alloc_traits = std::allocator_traits<typename Registry::allocator_type>;
+    template <class V>
+    using container = std::vector<V, typename alloc_traits::template rebind_alloc<V>>;
+
+    template <class Archive>
+    void put(Archive& ar, const void* data, size_t size) {
+        if (size) ar.write(data, size);
+        offset_ += size;
+    }
+
+    template <class Archive>
+    void pad(Archive& ar) {
+        static constexpr char zeros[detail::mapped_align]{};
+        put(ar, zeros, (detail::mapped_align - offset_ % detail::mapped_align) % detail::mapped_align);
+    }
+
+    static uint64_t aligned(uint64_t offset) {
+        return (offset + detail::mapped_align - 1) / detail::mapped_align * detail::mapped_align;
+    }
+
+    template <class Archive>
+    void section(Archive& ar, uint64_t hash, uint64_t alive, const entity_type* packed, size_t size,
+                 const void* payload, size_t value_size) {
+        if (offset_ == 0) {
+            put(ar, &detail::mapped_magic, sizeof(detail::mapped_magic));
+            pad(ar);
+        }
+
+        // sparse pages rebuilt from the packed array, only those in use
+        size_t pages = 0;
+        for (size_t i = 0; i < size; ++i)
+            pages = std::max<size_t>(pages, traits::id(packed[i]) / VIGNA_SPARSE_PAGE + 1);
+        container<uint64_t> table(pages, 0, reg_->get_allocator());
+        for (size_t i = 0; i < size; ++i) table[traits::id(packed[i]) / VIGNA_SPARSE_PAGE] = 1;
+        container<size_t> slot(pages, 0, reg_->get_allocator());
+        size_t used = 0;
+        for (size_t i = 0; i < pages; ++i)
+            if (table[i]) slot[i] = used++;
+        container<entity_value> content(used * VIGNA_SPARSE_PAGE, static_cast<entity_value>(null), reg_->get_allocator());
+        for (size_t i = 0; i < size; ++i) {
+            const auto id = traits::id(packed[i]);
+            content[slot[id / VIGNA_SPARSE_PAGE] * VIGNA_SPARSE_PAGE + id % VIGNA_SPARSE_PAGE] = static_cast<entity_value>(i);
+        }
+
+        detail::mapped_section head{};
+        head.hash = hash;
+        head.size = size;
+        head.alive = alive;
+        head.pages = pages;
+        head.packed = aligned(offset_ + sizeof(head));
+        head.sparse = aligned(head.packed + size * sizeof(entity_type));
+        const auto contents = aligned(head.sparse + pages * sizeof(uint64_t));
+        for (size_t i = 0; i < pages; ++i)
+            if (table[i]) table[i] = contents + slot[i] * VIGNA_SPARSE_PAGE * sizeof(entity_value);
+        head.payload = aligned(contents + content.size() * sizeof(entity_value));
+        head.next = aligned(head.payload + size * value_size);
+
+        put(ar, &head, sizeof(head));
+        pad(ar);
+        put(ar, packed, size * sizeof(entity_type));
+        pad(ar);
+        put(ar, table.data(), table.size() * sizeof(uint64_t));
+        pad(ar);
+        put(ar, content.data(), content.size() * sizeof(entity_value));
+        pad(ar);
+        put(ar, payload, size * value_size);
+        pad(ar);
+        assert(offset_ == head.next);
+    }
+
+public:
+    using registry_type = Registry;
+
+    explicit basic_mapped_snapshot(const Registry& reg) : reg_(&reg) {}
+
+    template <class Archive>
+    basic_mapped_snapshot& entities(Archive& ar) {
+        const auto& pool = *reg_->template assure<entity_type>();
+        section(ar, Registry::template type_hash<entity_type>(), pool.size(), pool.data(),
+                pool.size() + pool.cemetery_size(), nullptr, 0);
+        return *this;
+    }
+
+    template <class T, class Archive>
+    basic_mapped_snapshot& get(Archive& ar) {
+        using value_type = typename Registry::template storage_for_type<T>::value_type;
+        static_assert(std::is_void_v<value_type> || std::is_trivially_copyable_v<T>,
+                      "Only trivially copyable payloads can be served from a mapping");
+        static_assert(alignof(T) <= detail::mapped_align);
+        const auto* pool = reg_->template assure<T>();
+        const size_t size = pool ? pool->size() : 0;
+        const void* payload = nullptr;
+        if constexpr (!std::is_void_v<value_type>)
+            if (size) payload = std::addressof(*pool->cbegin());
+        section(ar, Registry::template type_hash<T>(), size, size ? pool->data() : nullptr, size,
+                payload, std::is_void_v<value_type> ? 0 : sizeof(T));
+        return *this;
+    }
+
+private:
+    const Registry* reg_;
+    uint64_t offset_ = 0;
+
+};
+
+template <class, class, class>
+class basic_mapped_view;
+
+// the entities in all the get pools and none of the exclude ones of a mapped registry,
+// walked along the smallest get pool; the pools are held by value and refer to the mapping
+template <class Mapped, class...Get, class...Exclude>
+class basic_mapped_view<Mapped, get_t<Get...>, exclude_t<Exclude...>> {
+    static_assert(sizeof...(Get) > 0, "Nothing to walk along");
+
+    using pool_tuple = std::tuple<typename Mapped::template storage_type<Get>...>;
+    using exclude_tuple = std::tuple<typename Mapped::template storage_type<Exclude>...>;
+
+    template <class T>
+    static constexpr size_t index_of = reflect::type_list_find_v<T, get_t<Get...>>;
+
+    template <class T>
+    auto get_as_tuple(const typename Mapped::entity_type& entity) const {
+        if constexpr (std::is_void_v<typename std::tuple_element_t<index_of<T>, pool_tuple>::value_type>)
+            return std::tuple<>{};
+        else
+            return std::forward_as_tuple(get<T>(entity));
+    }
+
+    auto get_iterable() const {
+        return view::filter(range::subrange{lead_, lead_ + lead_size_}, [this](auto&& e) { return contains(e); });
+    }
+
+public:
+    using entity_type = typename Mapped::entity_type;
+
+    basic_mapped_view() = default;
+    explicit basic_mapped_view(typename Mapped::template storage_type<Get>...get,
+                               typename Mapped::template storage_type<Exclude>...exclude)
+        : get_(get...), exclude_(exclude...) {
+        lead_size_ = SIZE_MAX;
+        std::apply([this](auto&&...p) { ((p.size() < lead_size_ ? (lead_ = p.data(), lead_size_ = p.size()) : 0), ...); }, get_);
+    }
+
+    auto begin() const { return get_iterable().begin(); }
+    auto end() const { return get_iterable().end(); }
+
+    [[nodiscard]] size_t size_hint() const { return lead_size_; }
+
+    [[nodiscard]] bool contains(const entity_type& entity) const {
+        return std::apply([&](auto&&...p) { return (p.contains(entity) && ...); }, get_)
+            && std::apply([&](auto&&...p) { return !(p.contains(entity) || ...); }, exclude_);
+    }
+
+    template <class T>
+    [[nodiscard]] const auto& storage() const { return std::get<index_of<T>>(get_); }
+
+    template <class T>
+    decltype(auto) get(const entity_type& entity) const { return storage<T>().get(entity); }
+
+    // the entity followed by the payloads of the get pools that have one
+    auto each() const {
+        return view::transform(*this, [this](auto&& e) {
+            return std::tuple_cat(std::make_tuple(e), get_as_tuple<Get>(e)...);
+        });
+    }
+
+    template <class Fn>
+    void for_each(Fn&& fn) const {
+        for (auto&& tp : each()) std::apply(fn, tp);
+    }
+
+private:
+    pool_tuple get_;
+    exclude_tuple exclude_;
+    const entity_type* lead_{};
+    size_t lead_size_{};
+
+};
+
+// a registry opened from a mapped snapshot without reading it, pools are found by type hash in a table
+// built on opening and served from the pages of the file as the kernel brings them in; with map_mode::copy_on_write,
+// payloads can be changed in place and only the touched pages get copied
+//
+// the headers and sparse tables are checked on opening, and payloads on first use against the size
+// of their type, so that nothing is read past the file: std::runtime_error if one does not fit
+template <class Registry>
+class basic_mapped_registry {
+    using traits = entity_traits<typename Registry::entity_type>;
+    using entity_value = typename traits::value_type;
+    using section_type = detail::mapped_section;
+
+    template <class T>
+    using value_type_of = typename Registry::template storage_for_type<T>::value_type;
+
+    [[noreturn]] static void corrupt() {
+        throw std::runtime_error("basic_mapped_registry: not a mapped snapshot or a damaged one");
+    }
+
+    // size bytes at offset, aligned as given, past the header of s and before the next one
+    static bool inside(const section_type& s, uint64_t head, uint64_t offset, uint64_t size, uint64_t align) {
+        return offset % align == 0 && offset >= head + sizeof(section_type) && offset <= s.next && size <= s.next - offset;
+    }
+
+    void check(const section_type& s, uint64_t head) const {
+        if (s.next <= head || s.next > file_.size() || s.next % detail::mapped_align) corrupt();
+        if (s.size > static_cast<uint64_t>(traits::id_max) + 1 || s.pages > traits::id_max / VIGNA_SPARSE_PAGE + 1) corrupt();
+        if (!inside(s, head, s.packed, s.size * sizeof(entity_type), detail::mapped_align)
+            || !inside(s, head, s.sparse, s.pages * sizeof(uint64_t), detail::mapped_align)
+            || !inside(s, head, s.payload, 0, detail::mapped_align)) corrupt();
+        const auto* pages = reinterpret_cast<const uint64_t*>(file_.data() + s.sparse);
+        for (uint64_t i = 0; i < s.pages; ++i)
+            if (pages[i] && !inside(s, head, pages[i], VIGNA_SPARSE_PAGE * sizeof(entity_value), alignof(entity_value))) corrupt();
+    }
+
+    // the sections form a chain from the first past the magic to the end of the file,
+    // walked once to check them and file them by type hash
+    void load() {
+        if (file_.size() < detail::mapped_align) corrupt();
+        uint64_t magic;
+        std::memcpy(&magic, file_.data(), sizeof(magic));
+        if (magic != detail::mapped_magic) corrupt();
+        for (uint64_t off = detail::mapped_align; off != file_.size();) {
+            if (off > file_.size() || sizeof(section_type) > file_.size() - off) corrupt();
+            const auto& s = *reinterpret_cast<const section_type*>(file_.data() + off);
+            check(s, off);
+            sections_.emplace(s.hash, &s);
+            off = s.next;
+        }
+    }
+
+    const section_type* find(uint64_t hash) const {
+        auto it = sections_.find(hash);
+        return it != sections_.end() ? it->second : nullptr;
+    }
+
+public:
+    using registry_type = Registry;
+    using entity_type = typename Registry::entity_type;
+    template <class T>
+    using storage_type = basic_mapped_pool<entity_type, value_type_of<T>>;
+
+    basic_mapped_registry() = default;
+    explicit basic_mapped_registry(mapped_file file) : file_(std::move(file)) {
+        if (!file_) return;
+        load();
+        if (const auto* s = find(Registry::template type_hash<entity_type>())) {
+            if (s->alive > s->size) corrupt();
+            entities_ = {file_.data(), *s}, alive_ = s->alive;
+        }
+    }
+    explicit basic_mapped_registry(const char* path, map_mode mode = map_mode::copy_on_write)
+        : basic_mapped_registry(mapped_file{path, mode}) {}
+
+    [[nodiscard]] bool valid(const entity_type& entity) const {
+        const auto index = entities_.find_index(entity);
+        return index != null && index < alive_ && entities_[index] == entity;
+    }
+
+    [[nodiscard]] size_t alive() const { return alive_; }
+
+    // an empty pool when the snapshot has none for T
+    template <class T>
+    storage_type<T> storage() const {
+        const auto* s = find(Registry::template type_hash<T>());
+        if (!s) return {};
+        if constexpr (!std::is_void_v<value_type_of<T>>)
+            if (s->size * sizeof(T) > s->next - s->payload) corrupt();
+        return storage_type<T>{file_.data(), *s};
+    }
+
+    template <class...T>
+    [[nodiscard]] bool all_of(const entity_type& entity) const {
+        return (storage<T>().contains(entity) && ...);
+    }
+
+    template <class T>
+    decltype(auto) get(const entity_type& entity) const {
+        return storage<T>().get(entity);
+    }
+
+    template <class...Get, class...Exclude>
+    auto view(exclude_t<Exclude...> = exclude_t<>{}) const {
+        return basic_mapped_view<basic_mapped_registry, get_t<Get...>, exclude_t<Exclude...>>{storage<Get>()..., storage<Exclude>()...};
+    }
+
+    [[nodiscard]] const mapped_file& file() const { return file_; }
+
+private:
+    mapped_file file_;
+    dense_map<uint64_t, const section_type*> sections_;
+    basic_mapped_pool<entity_type, void> entities_;
+    size_t alive_ = 0;
+
+};
+
+}
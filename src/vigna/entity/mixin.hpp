@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "vigna/core/span.hpp"
 #include "vigna/signal/signal.hpp"
 #include "vigna/signal/sink.hpp"
 
@@ -25,6 +26,20 @@ template<class Type, class Registry>
 struct has_on_destroy<Type, Registry, std::void_t<decltype(Type::on_destroy(std::declval<Registry&>(), std::declval<typename Registry::entity_type>()))>>
     : std::true_type {};
 
+template<class, class, class = void>
+struct has_on_construct_batch final: std::false_type {};
+
+template<class Type, class Registry>
+struct has_on_construct_batch<Type, Registry, std::void_t<decltype(Type::on_construct_batch(std::declval<Registry&>(), std::declval<span<const typename Registry::entity_type>>()))>>
+    : std::true_type {};
+
+template<class, class, class = void>
+struct has_on_destroy_batch final: std::false_type {};
+
+template<class Type, class Registry>
+struct has_on_destroy_batch<Type, Registry, std::void_t<decltype(Type::on_destroy_batch(std::declval<Registry&>(), std::declval<span<const typename Registry::entity_type>>()))>>
+    : std::true_type {};
+
 template<class, class, class = void>
 struct has_on_update final: std::false_type {};
 
@@ -39,8 +54,14 @@ class basic_signal_mixin final: public Type {
     using underlying_type = Type;
     using owner_type = Registry;
 
+    using common_type = typename underlying_type::base_type;
+    using common_iterator = typename common_type::iterator;
+
     using signal_type = signal_alloc<typename underlying_type::allocator_type, owner_type&, const typename underlying_type::entity_type>;
     using sink_type = sink<signal_type>;
+    // bulk operations emit once with every entity involved
+    using batch_signal_type = signal_alloc<typename underlying_type::allocator_type, owner_type&, span<const typename underlying_type::entity_type>>;
+    using batch_sink_type = sink<batch_signal_type>;
 
     void auto_connect() {
         if constexpr(detail::has_on_construct<typename underlying_type::element_type, Registry>::value) {
@@ -52,6 +73,12 @@ class basic_signal_mixin final: public Type {
         if constexpr(detail::has_on_update<typename underlying_type::element_type, Registry>::value) {
             update_.template connect<&underlying_type::element_type::on_update>();
         }
+        if constexpr(detail::has_on_construct_batch<typename underlying_type::element_type, Registry>::value) {
+            construction_batch_.template connect<&underlying_type::element_type::on_construct_batch>();
+        }
+        if constexpr(detail::has_on_destroy_batch<typename underlying_type::element_type, Registry>::value) {
+            destruction_batch_.template connect<&underlying_type::element_type::on_destroy_batch>();
+        }
     }
 
     owner_type& owner_or_assert() const {
@@ -64,19 +91,63 @@ class basic_signal_mixin final: public Type {
         underlying_type::swap_and_pop(index);
     }
 
+    [[nodiscard]] span<const typename underlying_type::entity_type> packed(size_t from, size_t to) const {
+        return {common_type::data() + from, common_type::data() + to};
+    }
+
+    // for clone, listeners stay with the original and the copy has no owner until bound
+    basic_signal_mixin(const basic_signal_mixin& other)
+        : underlying_type(other), construction_(other.get_allocator()), destruction_(other.get_allocator()), update_(other.get_allocator()),
+          construction_batch_(other.get_allocator()), destruction_batch_(other.get_allocator()) { auto_connect(); }
+
 public:
     using allocator_type = typename underlying_type::allocator_type;
     using entity_type = typename underlying_type::entity_type;
     using registry_type = owner_type;
 
-    basic_signal_mixin() { auto_connect(); }
-    explicit basic_signal_mixin(owner_type* owner) : owner_(owner) { auto_connect(); }
+    basic_signal_mixin() : basic_signal_mixin(allocator_type{}) {}
+    explicit basic_signal_mixin(const allocator_type& alloc)
+        : underlying_type(alloc), construction_(alloc), destruction_(alloc), update_(alloc),
+          construction_batch_(alloc), destruction_batch_(alloc) { auto_connect(); }
+    explicit basic_signal_mixin(owner_type* owner, const allocator_type& alloc = {})
+        : basic_signal_mixin(alloc) { owner_ = owner; }
+
+    basic_signal_mixin(basic_signal_mixin&&) = default;
+    basic_signal_mixin& operator=(basic_signal_mixin&&) = default;
+
+    [[nodiscard]] std::shared_ptr<common_type> clone() const override {
+        if constexpr (std::is_copy_constructible_v<typename underlying_type::element_type>) {
+            return detail::make_pool<basic_signal_mixin>(this->get_allocator(), [this](void* p) { ::new (p) basic_signal_mixin(*this); });
+        } else {
+            assert(false && "Pool of a type that cannot be copied");
+            return nullptr;
+        }
+    }
 
     void bind(void* owner) override { assert(owner), owner_ = static_cast<owner_type*>(owner); }
 
+    // for a copy taking the place of the original, connections follow their signals
+    void take_signals(common_type& other) override {
+        auto& from = static_cast<basic_signal_mixin&>(other);
+        construction_.take(from.construction_);
+        destruction_.take(from.destruction_);
+        update_.take(from.update_);
+        construction_batch_.take(from.construction_batch_);
+        destruction_batch_.take(from.destruction_batch_);
+    }
+
+    [[nodiscard]] pool_memory_stats memory_stats() const override {
+        auto stats = underlying_type::memory_stats();
+        stats.signal_bytes = construction_.memory_size() + destruction_.memory_size() + update_.memory_size()
+            + construction_batch_.memory_size() + destruction_batch_.memory_size();
+        return stats;
+    }
+
     auto on_construct() { return sink_type{construction_}; }
     auto on_destroy() { return sink_type{destruction_}; }
     auto on_update() { return sink_type{update_}; }
+    auto on_construct_batch() { return batch_sink_type{construction_batch_}; }
+    auto on_destroy_batch() { return batch_sink_type{destruction_batch_}; }
 
     auto emplace() {
         const auto entity = underlying_type::emplace();
@@ -105,12 +176,43 @@ public:
         underlying_type::insert(std::forward<First_>(first),
                                 std::forward<Last_>(last),
                                 std::forward<Args>(args)...);
+        const auto to = underlying_type::size();
+        if(!construction_batch_.empty() && from != to)
+            construction_batch_.emit(owner_or_assert(), packed(from, to));
         if(auto &reg = owner_or_assert(); !construction_.empty())
-            for(const auto to = underlying_type::size(); from != to; ++from)
+            for(; from != to; ++from)
                 construction_.emit(reg, underlying_type::operator[](from));
     }
 
+    // bulk replacement for loaders, the old content is cleared first so that its destruction is seen
+    template <class...Args>
+    void assign(Args&&...args) {
+        if (!underlying_type::empty()) clear();
+        underlying_type::assign(std::forward<Args>(args)...);
+        const auto to = underlying_type::size();
+        if (!construction_batch_.empty() && to != 0)
+            construction_batch_.emit(owner_or_assert(), packed(0, to));
+        if (auto& reg = owner_or_assert(); !construction_.empty())
+            for (size_t i = 0; i != to; ++i)
+                construction_.emit(reg, underlying_type::operator[](i));
+    }
+
+    using underlying_type::pop;
+
+    size_t pop(common_iterator first, common_iterator last) final {
+        if (!destruction_batch_.empty()) {
+            std::vector<entity_type, typename std::allocator_traits<allocator_type>::template rebind_alloc<entity_type>> batch(
+                typename std::allocator_traits<allocator_type>::template rebind_alloc<entity_type>{this->get_allocator()});
+            std::copy_if(first, last, std::back_inserter(batch), [this](const entity_type& e) { return this->contains(e); });
+            if (!batch.empty())
+                destruction_batch_.emit(owner_or_assert(), batch);
+        }
+        return underlying_type::pop(first, last);
+    }
+
     void clear() final {
+        if (!destruction_batch_.empty() && !underlying_type::empty())
+            destruction_batch_.emit(owner_or_assert(), packed(0, underlying_type::size()));
         if (!destruction_.empty())
             for (size_t i = 0; i < underlying_type::size(); ++i)
                 destruction_.emit(owner_or_assert(), underlying_type::operator[](i));
@@ -126,9 +228,11 @@ public:
 
 private:
     owner_type* owner_{};
-    signal_type construction_{};
-    signal_type destruction_{};
-    signal_type update_{};
+    signal_type construction_;
+    signal_type destruction_;
+    signal_type update_;
+    batch_signal_type construction_batch_;
+    batch_signal_type destruction_batch_;
 
 };
 
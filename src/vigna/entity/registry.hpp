@@ -4,9 +4,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
 #include "view.hpp"
 #include "mixin.hpp"
+#include "component.hpp"
 #include "vigna/core/dense_map.hpp"
+#include "vigna/range/execution.hpp"
 #include "vigna/reflect/utility.hpp"
 #include "vigna/reflect/type_hash.hpp"
 
@@ -15,14 +23,18 @@ namespace vigna {
 template <class, class>
 class basic_registry;
 
+template <class>
+class basic_registry_snapshot;
+
 namespace detail {
 
-template <class T, class Alloc>
-using mixin_type_t = VIGNA_MIXIN(basic_signal_mixin, T, basic_registry<typename T::entity_type, Alloc>);
+template <class T, class Alloc, class Type>
+using mixin_type_t = std::conditional_t<component_traits<Type>::signals,
+    VIGNA_MIXIN(basic_signal_mixin, T, basic_registry<typename T::entity_type, Alloc>), T>;
 
 template <class T, class Entity, class Alloc>
 using storage_type_t = mixin_type_t<basic_storage<Entity, T, Alloc>,
-    typename std::allocator_traits<Alloc>::template rebind_alloc<Entity>>;
+    typename std::allocator_traits<Alloc>::template rebind_alloc<Entity>, T>;
 
 template <class T, class Entity, class Alloc>
 using storage_for_t = reflect::constness_as_t<storage_type_t<std::remove_const_t<T>, Entity, Alloc>, T>;
@@ -48,23 +60,48 @@ class basic_registry {
     template<class T>
     static constexpr auto type_hash() { return reflect::type_hash<T, hash_value>(); }
 
+    template <class>
+    friend class basic_snapshot;
+    template <class>
+    friend class basic_snapshot_loader;
+    template <class, class>
+    friend class basic_async_snapshot;
+    template <class, class...>
+    friend class basic_delta_recorder;
+    template <class>
+    friend class basic_delta_loader;
+    template <class>
+    friend class basic_mapped_snapshot;
+    template <class>
+    friend class basic_mapped_registry;
+    template <class>
+    friend class basic_registry_snapshot;
+    template <class, class...>
+    friend class basic_rollback;
+    template <class>
+    friend class basic_column_export;
+
 protected:
     template <class T>
     decltype(auto) assure(hash_value id = type_hash<T>()) {
         static_assert(std::is_same_v<T, std::decay_t<T>>, "Non-decayed types not allowed");
         if constexpr (std::is_same_v<T, Entity>) {
             assert(id == type_hash<Entity>() && "User entity storage not allowed");
-            return entities_;
+            detach(entities_);
+            return (*entities_);
         } else {
             using storage_type = storage_for_type<T>;
-            using alloc_type = typename alloc_traits::template rebind_alloc<storage_type>;
 
             if (auto it = pools_.find(id); it != pools_.end()) {
                 assert(dynamic_cast<storage_type*>(&*it->second) != nullptr && "Unexpected storage type");
+                detach(it->second);
                 return static_cast<storage_type&>(*it->second);
             }
 
-            auto storage = std::allocate_shared<storage_type>(alloc_type{});
+            assert(!frozen_ && "Pool registered on a frozen registry");
+            auto storage = detail::make_pool<storage_type>(get_allocator(), [this](void* p) {
+                ::new (p) storage_type{typename storage_type::allocator_type{get_allocator()}};
+            });
             pools_.emplace(id, storage);
             storage->bind(this);
             return *storage;
@@ -76,7 +113,7 @@ protected:
         static_assert(std::is_same_v<T, std::decay_t<T>>, "Non-decayed types not allowed");
         if constexpr (std::is_same_v<T, Entity>) {
             assert(id == type_hash<Entity>() && "User entity storage not allowed");
-            return &entities_;
+            return entities_.get();
         } else {
             using storage_type = storage_for_type<const T>;
 
@@ -94,41 +131,77 @@ public:
     using version_type = typename traits::version_type;
     using common_type = base_type;
 
-    basic_registry() = default;
+    basic_registry() : basic_registry(allocator_type{}) {}
+    explicit basic_registry(const allocator_type& alloc)
+        : pools_{typename pool_container_type::allocator_type{alloc}}, entities_{make_entities(alloc)} {
+        entities_->bind(this);
+    }
+
+    // pools know their owner, which moves along; the registry moved from is left empty, with an entity pool
+    // of its own, so that it can go on
+    basic_registry(basic_registry&& other)
+        : pools_{std::move(other.pools_)}, entities_{std::exchange(other.entities_, make_entities(other.get_allocator()))},
+          frozen_{other.frozen_} {
+        rebind();
+        other.pools_.clear(); // a moved from table keeps its counts
+        other.entities_->bind(&other);
+    }
+    basic_registry& operator=(basic_registry&& other) {
+        if (this == &other) return *this;
+        pools_ = std::move(other.pools_);
+        entities_ = std::exchange(other.entities_, make_entities(other.get_allocator()));
+        frozen_ = other.frozen_;
+        rebind();
+        other.pools_.clear();
+        other.entities_->bind(&other);
+        return *this;
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const { return allocator_type{pools_.get_allocator()}; }
+
+    // registers the pools up front, so that a frozen registry never touches its pool table
+    template <class...T>
+    void prepare() {
+        (assure<T>(), ...);
+    }
+
+    void freeze(bool frozen = true) { frozen_ = frozen; }
+    [[nodiscard]] bool frozen() const { return frozen_; }
 
     [[nodiscard]] bool valid(const entity_type& entity) const {
-        return entities_.valid(entity);
+        return entities_->valid(entity);
     }
 
     [[nodiscard]] version_type current(const entity_type& entity) const {
-        return entities_.current(entity);
+        return entities_->current(entity);
     }
 
     auto create() {
-        return entities_.emplace();
+        return assure<Entity>().emplace();
     }
 
     auto create(const entity_type& hint) {
-        return entities_.emplace(hint);
+        return assure<Entity>().emplace(hint);
     }
 
     template <class First_, class Last_>
     void create(First_&& first, Last_&& last) {
-        entities_.insert(std::forward<First_>(first), std::forward<Last_>(last));
+        assure<Entity>().insert(std::forward<First_>(first), std::forward<Last_>(last));
     }
 
     version_type destroy(const entity_type& entity) {
         for (auto&& [_, i] : pools_)
-            i->pop(entity);
-        entities_.erase(entity);
-        return entities_.current(entity);
+            if (i->contains(entity)) detach(i), i->pop(entity);
+        auto& entities = assure<Entity>();
+        entities.erase(entity);
+        return entities.current(entity);
     }
 
     template <class First_, class Last_>
     void destroy(First_&& first, Last_&& last) {
         for (auto&& [_, i] : pools_)
-            i->pop(std::forward<First_>(first), std::forward<Last_>(last));
-        entities_.erase(std::forward<First_>(first), std::forward<Last_>(last));
+            if (std::any_of(first, last, [&](auto&& e) { return i->contains(e); })) detach(i), i->pop(first, last);
+        assure<Entity>().pop(first, last);
     }
 
     template <class T, class...Args>
@@ -224,7 +297,7 @@ public:
 
     template <class...Args>
     [[nodiscard]] bool all_of(const entity_type& entity) const {
-        if constexpr (sizeof...(Args) == 0) {
+        if constexpr (sizeof...(Args) == 1) {
             auto p = assure<Args...>();
             return p && p->contains(entity);
         } else {
@@ -279,6 +352,8 @@ public:
     template<class...Args>
     [[nodiscard]] auto try_get(const entity_type& entity) {
         if constexpr (sizeof...(Args) == 1) {
+            if (auto it = pools_.find(type_hash<Args...>()); it != pools_.end())
+                detach(it->second);
             return (const_cast<Args*>(std::as_const(*this).template try_get<Args>(entity)), ...);
         } else {
             return std::make_tuple(try_get<Args>(entity)...);
@@ -301,19 +376,34 @@ public:
 
     template<class T>
     [[nodiscard]] auto on_construct(const hash_value id = type_hash<T>()) {
+        static_assert(component_traits<T>::signals, "Signals disabled by component_traits");
         return assure<T>(id).on_construct();
     }
 
     template<class T>
     [[nodiscard]] auto on_destroy(const hash_value id = type_hash<T>()) {
+        static_assert(component_traits<T>::signals, "Signals disabled by component_traits");
         return assure<T>(id).on_destroy();
     }
 
     template<class T>
     [[nodiscard]] auto on_update(const hash_value id = type_hash<T>()) {
+        static_assert(component_traits<T>::signals, "Signals disabled by component_traits");
         return assure<T>(id).on_update();
     }
 
+    template<class T>
+    [[nodiscard]] auto on_construct_batch(const hash_value id = type_hash<T>()) {
+        static_assert(component_traits<T>::signals, "Signals disabled by component_traits");
+        return assure<T>(id).on_construct_batch();
+    }
+
+    template<class T>
+    [[nodiscard]] auto on_destroy_batch(const hash_value id = type_hash<T>()) {
+        static_assert(component_traits<T>::signals, "Signals disabled by component_traits");
+        return assure<T>(id).on_destroy_batch();
+    }
+
     template<class...Get, class...Exclude>
     auto view(exclude_t<Exclude...> = exclude_t<>{}) {
         using view_type = basic_view<base_type, get_t<storage_for_type<Get>...>, exclude_t<storage_for_type<Exclude>...>>;
@@ -326,9 +416,202 @@ public:
         return view_type{assure<Get>()..., assure<Exclude>()...};
     }
 
+    // a deep copy to run ahead on, pools are copied on the threads of the policy given, one each;
+    // listeners stay with this registry, component hooks (on_construct...) come along.
+    // throws std::logic_error, before copying anything, if a pool holds a type that cannot be copied
+    template <class Policy = execution::sequenced_policy, class = std::enable_if_t<execution::is_execution_policy_v<Policy>>>
+    [[nodiscard]] basic_registry clone(const Policy& policy = {}) const {
+        for (auto&& [_, pool] : pools_)
+            if (!pool->cloneable()) throw std::logic_error("basic_registry::clone: pool of a type that cannot be copied");
+        basic_registry other{get_allocator()};
+        other.entities_ = std::static_pointer_cast<storage_for_type<Entity>>(entities_->clone());
+        other.frozen_ = frozen_;
+
+        using copy_type = std::pair<hash_value, std::shared_ptr<base_type>>;
+        std::vector<copy_type, typename alloc_traits::template rebind_alloc<copy_type>> copies(get_allocator());
+        copies.reserve(pools_.size());
+        for (auto&& [id, _] : pools_) copies.emplace_back(id, nullptr);
+        auto copy = [&](size_t i) { copies[i].second = pools_.find(copies[i].first)->second->clone(); };
+        if constexpr (std::is_same_v<decltype(execution::policy_of(policy)), execution::parallel_policy>)
+            execution::policy_of(policy).executor().run(copies.size(), copy);
+        else
+            for (size_t i = 0; i < copies.size(); ++i) copy(i);
+
+        for (auto&& [id, pool] : copies)
+            other.pools_.emplace(id, std::move(pool));
+        other.rebind();
+        return other;
+    }
+
+    // a read only view of the registry as it is now, for readers on other threads while this one goes on;
+    // the pools are shared, not copied, and a pool is copied on its first write through the registry
+    // while a snapshot still holds it. references to pools or components kept from before the snapshot
+    // would write to the snapshot instead, which asserts in debug builds; take them again, and pool locks too,
+    // as the copy comes with a guard and an access_tracker of its own, see basic_pool_lock.
+    // pools of types that cannot be copied are left out, and snapshots refuse to compile reads of them
+    [[nodiscard]] basic_registry_snapshot<basic_registry> snapshot() {
+        basic_registry_snapshot<basic_registry> snap{get_allocator()};
+        entities_->read_only(true);
+        snap.entities_ = entities_;
+        for (auto&& [id, pool] : pools_) {
+            if (!pool->cloneable()) continue;
+            pool->read_only(true);
+            snap.pools_.emplace(id, pool);
+        }
+        return snap;
+    }
+
+    // the pools by type hash, the entity pool first, and the table that holds them
+    struct memory_stats_type {
+        using pool_stats = std::pair<hash_value, pool_memory_stats>;
+        using pool_container = std::vector<pool_stats, typename alloc_traits::template rebind_alloc<pool_stats>>;
+
+        pool_container pools;
+        size_t pool_nodes{};
+        size_t pool_node_capacity{};
+        size_t pool_node_bytes{};
+        size_t pool_buckets{};
+        size_t pool_bucket_bytes{};
+
+        [[nodiscard]] size_t total_bytes() const {
+            size_t bytes = pool_node_bytes + pool_bucket_bytes;
+            for (auto&& [_, stats] : pools) bytes += stats.total_bytes();
+            return bytes;
+        }
+    };
+
+    // walks every pool once, see basic_sparse_set::memory_stats
+    [[nodiscard]] memory_stats_type memory_stats() const {
+        memory_stats_type stats{typename memory_stats_type::pool_container{get_allocator()}};
+        stats.pools.reserve(pools_.size() + 1);
+        stats.pools.emplace_back(type_hash<Entity>(), entities_->memory_stats());
+        for (auto&& [id, pool] : pools_) stats.pools.emplace_back(id, pool->memory_stats());
+        stats.pool_nodes = pools_.size();
+        stats.pool_node_capacity = pools_.capacity();
+        stats.pool_node_bytes = pools_.node_memory_size();
+        stats.pool_buckets = pools_.bucket_count();
+        stats.pool_bucket_bytes = pools_.bucket_memory_size();
+        return stats;
+    }
+
+private:
+    static std::shared_ptr<storage_for_type<Entity>> make_entities(const allocator_type& alloc) {
+        return detail::make_pool<storage_for_type<Entity>>(alloc, [&](void* p) { ::new (p) storage_for_type<Entity>{alloc}; });
+    }
+
+    void rebind() {
+        entities_->bind(this);
+        for (auto&& [_, i] : pools_) i->bind(this);
+    }
+
+    // a pool a snapshot took is copied before its first write if the snapshot still holds it,
+    // the snapshot keeps the original; otherwise it is writable again as it is
+    template <class Pool>
+    Pool* detach(std::shared_ptr<Pool>& pool) {
+        if (!pool->read_only()) return pool.get();
+        if (pool.use_count() > 1) {
+            auto copy = std::static_pointer_cast<Pool>(pool->clone());
+            copy->bind(this);
+            copy->take_signals(*pool);
+            pool = std::move(copy);
+        } else {
+            std::atomic_thread_fence(std::memory_order_acquire); // after the reads of the last snapshot
+            pool->read_only(false);
+        }
+        return pool.get();
+    }
+
+    pool_container_type pools_;
+    std::shared_ptr<storage_for_type<Entity>> entities_;
+    bool frozen_{};
+
+};
+
+// what registry.snapshot() hands out, the const part of the registry over pools nobody writes to,
+// cheap to copy and safe to read from any number of threads
+template <class Registry>
+class basic_registry_snapshot {
+    friend Registry;
+    template <class, class>
+    friend class basic_async_snapshot;
+
+    using entity_type = typename Registry::entity_type;
+    using base_type = typename Registry::common_type;
+    using alloc_traits = std::allocator_traits<typename Registry::allocator_type>;
+    using hash_value = typename Registry::hash_value;
+    using pool_container_type = dense_map<hash_value, std::shared_ptr<const base_type>,
+        std::hash<hash_value>, std::equal_to<hash_value>,
+        typename alloc_traits::template rebind_alloc<std::pair<const hash_value, std::shared_ptr<const base_type>>>>;
+
+    template <class T>
+    using storage_for_type = typename Registry::template storage_for_type<T>;
+
+    explicit basic_registry_snapshot(const typename Registry::allocator_type& alloc)
+        : pools_{typename pool_container_type::allocator_type{alloc}} {}
+
+    template <class T>
+    const storage_for_type<const T>* assure() const {
+        static_assert(std::is_void_v<typename storage_for_type<T>::value_type> || std::is_copy_constructible_v<T>,
+                      "Pools of types that cannot be copied are left out of snapshots");
+        auto it = pools_.find(Registry::template type_hash<T>());
+        if (it == pools_.end()) return nullptr;
+        assert(dynamic_cast<const storage_for_type<const T>*>(&*it->second) != nullptr && "Unexpected storage type");
+        return static_cast<const storage_for_type<const T>*>(&*it->second);
+    }
+
+    [[nodiscard]] const storage_for_type<const entity_type>& entities() const {
+        return static_cast<const storage_for_type<const entity_type>&>(*entities_);
+    }
+
+public:
+    using registry_type = Registry;
+
+    [[nodiscard]] bool valid(const entity_type& entity) const {
+        return entities().valid(entity);
+    }
+
+    [[nodiscard]] auto current(const entity_type& entity) const {
+        return entities().current(entity);
+    }
+
+    template <class...Args>
+    [[nodiscard]] bool all_of(const entity_type& entity) const {
+        return ([&](auto* p) { return p && p->contains(entity); }(assure<Args>()) && ...);
+    }
+
+    template <class...Args>
+    [[nodiscard]] bool any_of(const entity_type& entity) const {
+        return (all_of<Args>(entity) || ...);
+    }
+
+    template <class...T>
+    [[nodiscard]] decltype(auto) get(const entity_type& entity) const {
+        if constexpr (sizeof...(T) == 1) {
+            return (assure<T>()->get(entity), ...);
+        } else {
+            return std::forward_as_tuple(get<T>(entity)...);
+        }
+    }
+
+    template <class...Args>
+    [[nodiscard]] auto try_get(const entity_type& entity) const {
+        if constexpr (sizeof...(Args) == 1) {
+            const auto* cpool = assure<Args...>();
+            return (cpool && cpool->contains(entity)) ? std::addressof(cpool->get(entity)) : nullptr;
+        } else {
+            return std::make_tuple(try_get<Args>(entity)...);
+        }
+    }
+
+    template <class...Get, class...Exclude>
+    auto view(exclude_t<Exclude...> = exclude_t<>{}) const {
+        using view_type = basic_view<std::add_const_t<base_type>, get_t<std::add_const_t<storage_for_type<Get>>...>, exclude_t<std::add_const_t<storage_for_type<Exclude>>...>>;
+        return view_type{assure<Get>()..., assure<Exclude>()...};
+    }
+
 private:
-    pool_container_type pools_{};
-    storage_for_type<Entity> entities_{this};
+    pool_container_type pools_;
+    std::shared_ptr<const base_type> entities_;
 
 };
 
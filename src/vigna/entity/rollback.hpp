@@ -0,0 +1,224 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "registry.hpp"
+
+namespace vigna {
+
+// keeps the last frames of the entity pool and of the pools of Type..., as the pages of their packed
+// and payload arrays that each frame wrote, and rolls them back in bulk; sparse entries of the
+// pages rolled back are redone from the packed array instead of being kept
+//
+// pools mark the pages their mutable accessors hand out (get, patch, find, each, iterators) and those
+// their structural operations move, a save compares only these with its copy from the previous save,
+// and a restore puts back only these; a reference or an iterator kept across a save or a restore is not
+// seen writing, get it again as with snapshots. one rollback per registry, rolling back emits no signal
+template <class Registry, class...Type>
+class basic_rollback {
+    using entity_type = typename Registry::entity_type;
+    using traits = entity_traits<entity_type>;
+    using allocator_type = typename Registry::allocator_type;
+    using alloc_traits = std::allocator_traits<allocator_type>;
+    template <class V>
+    using container = std::vector<V, typename alloc_traits::template rebind_alloc<V>>;
+
+    // the rows of a dirty bit, for the packed and the payload array alike
+    static constexpr size_t page = basic_sparse_set<entity_type, typename alloc_traits::template rebind_alloc<entity_type>>::dirty_rows;
+
+    template <class T>
+    using payload_of = typename Registry::template storage_for_type<T>::value_type;
+
+    // what one array was before a frame, its size and the pages the frame wrote
+    template <class V>
+    struct record {
+        explicit record(const allocator_type& alloc) : pages(alloc), data(alloc) {}
+
+        size_t size{};
+        container<std::pair<size_t, size_t>> pages; // first element of the page, where its content starts in data
+        container<V> data;
+    };
+
+    // the old content of those of the pages where live and the shadow differ goes to out,
+    // then the shadow becomes live; the other pages have to be the same already
+    template <class V, class Live>
+    static void diff(container<V>& shadow, const Live& live, const container<size_t>& pages, record<V>& out) {
+        const auto old = shadow.size(), n = live.size();
+        out.size = old;
+        out.pages.clear();
+        out.data.clear();
+        for (auto lo : pages) {
+            const auto hi_old = std::clamp(old, lo, lo + page), hi_new = std::clamp(n, lo, lo + page);
+            if (hi_old == hi_new && std::memcmp(live.data() + lo, shadow.data() + lo, (hi_old - lo) * sizeof(V)) == 0)
+                continue;
+            out.pages.emplace_back(lo, out.data.size());
+            out.data.insert(out.data.end(), shadow.begin() + lo, shadow.begin() + hi_old);
+        }
+
+        if (n < old) shadow.erase(shadow.begin() + n, shadow.end());
+        for (auto&& [lo, _] : out.pages)
+            std::copy(live.begin() + lo, live.begin() + std::clamp(std::min(n, old), lo, lo + page), shadow.begin() + lo);
+        if (n > old) shadow.insert(shadow.end(), live.begin() + old, live.end());
+    }
+
+    // puts the pages of a record back in an array, leave sees the indices about to be rewritten, enter those rewritten
+    template <class Array, class V, class Leave, class Enter>
+    static void undo(Array& arr, const record<V>& rec, Leave&& leave, Enter&& enter) {
+        const auto cur = arr.size(), old = rec.size;
+        for (auto&& [lo, _] : rec.pages)
+            for (auto i = lo, hi = std::min(lo + page, cur); i < hi; ++i) leave(i);
+
+        if (old < cur) arr.erase(arr.begin() + old, arr.end());
+        for (size_t k = 0; k < rec.pages.size(); ++k) {
+            const auto [lo, at] = rec.pages[k];
+            const auto len = (k + 1 < rec.pages.size() ? rec.pages[k + 1].second : rec.data.size()) - at;
+            const auto* d = rec.data.data() + at;
+            const auto common = lo < arr.size() ? std::min(len, arr.size() - lo) : 0;
+            std::copy(d, d + common, arr.begin() + lo);
+            arr.insert(arr.end(), d + common, d + len); // pages past the end come in order
+        }
+
+        for (auto&& [lo, _] : rec.pages)
+            for (auto i = lo, hi = std::min(lo + page, old); i < hi; ++i) enter(i);
+    }
+
+    // the shadow of one pool and its records, one per frame of the ring
+    template <class T>
+    struct history {
+        static constexpr bool has_payload = !std::is_void_v<payload_of<T>>;
+        using value_type = std::conditional_t<has_payload, T, char>;
+        static_assert(!has_payload || std::is_trivially_copyable_v<T>, "Rollback works on the bytes of payloads");
+
+        struct frame {
+            explicit frame(const allocator_type& alloc) : packed(alloc), payload(alloc) {}
+
+            record<entity_type> packed;
+            record<value_type> payload;
+            size_t alive{};
+        };
+
+        history(Registry& reg, size_t capacity)
+            : reg(&reg), packed(reg.get_allocator()), payload(reg.get_allocator()),
+              frames(capacity, frame{reg.get_allocator()}, reg.get_allocator()), scratch(reg.get_allocator()),
+              pages(reg.get_allocator()) {
+            reg.template assure<T>();
+        }
+
+        // the first element of every page marked since the last call, and of those the size moved over;
+        // a pool not tracked yet, the first one or one the registry put in anew, is all dirty
+        template <class Pool>
+        void take_dirty(const Pool& pool, size_t n) {
+            const auto old = packed.size(), from = std::min(old, n) / page, to = (std::max(old, n) + page - 1) / page;
+            pages.clear();
+            if (!pool.tracked_ || pool.all_dirty_) {
+                for (size_t i = 0; i < to; ++i) pages.push_back(i * page);
+            } else {
+                for (size_t w = 0; w < pool.dirty_.size() && w * 64 < from; ++w)
+                    for (auto bits = pool.dirty_[w], k = uint64_t{}; bits != 0; ++k, bits >>= 1)
+                        if (bits & 1 && w * 64 + k < from) pages.push_back((w * 64 + k) * page);
+                for (auto i = from; i < to; ++i) pages.push_back(i * page);
+            }
+            std::fill(pool.dirty_.begin(), pool.dirty_.end(), 0);
+            pool.tracked_ = true;
+            pool.all_dirty_ = false;
+        }
+
+        // looked up on every use, as the registry swaps pools for copies while snapshots hold them
+        void capture(frame& out) {
+            const auto& pool = *std::as_const(*reg).template assure<T>();
+            if constexpr (std::is_same_v<T, entity_type>) out.alive = alive, alive = pool.length_;
+            take_dirty(pool, pool.packed_.size());
+            diff(packed, pool.packed_, pages, out.packed);
+            if constexpr (has_payload) diff(payload, pool.payload_, pages, out.payload);
+        }
+
+        void apply(const frame& in) {
+            auto none = [](size_t) {};
+            if constexpr (std::is_same_v<T, entity_type>)
+                if (in.alive != alive) reg->template assure<T>().length_ = alive = in.alive;
+            if (in.packed.pages.empty() && in.payload.pages.empty()) return;
+            auto& pool = reg->template assure<T>();
+
+            undo(packed, in.packed, none, none);
+            undo(pool.packed_, in.packed,
+                 [&](size_t i) { pool.isolate(traits::id(pool.packed_[i])); },
+                 [&](size_t i) { pool.sparse_emplace(traits::id(pool.packed_[i]), static_cast<typename traits::value_type>(i)); });
+            if constexpr (has_payload) {
+                undo(payload, in.payload, none, none);
+                undo(pool.payload_, in.payload, none, none);
+            }
+        }
+
+        Registry* reg;
+        container<entity_type> packed;
+        container<value_type> payload;
+        size_t alive{};
+        container<frame> frames;
+        frame scratch; // unsaved changes, on their way back
+        container<size_t> pages;
+    };
+
+    template <class Fn>
+    void each_history(Fn&& fn) {
+        fn(entities_);
+        std::apply([&](auto&...h) { (fn(h), ...); }, pools_);
+    }
+
+    [[nodiscard]] size_t newest() const { return (head_ + count_ - 1) % capacity_; }
+
+public:
+    using registry_type = Registry;
+
+    // capacity is the number of saves that can be gone back over, the state at construction counts as saved
+    basic_rollback(Registry& reg, size_t capacity)
+        : capacity_(capacity), entities_(reg, capacity), pools_(history<Type>{reg, capacity}...) {
+        assert(capacity != 0);
+        each_history([](auto& h) { h.capture(h.scratch); });
+    }
+
+    // the end of a frame, what it wrote becomes a frame of the ring, the oldest one is dropped when full
+    void save() {
+        if (count_ == capacity_) head_ = (head_ + 1) % capacity_, --count_;
+        const auto slot = (head_ + count_++) % capacity_;
+        each_history([&](auto& h) { h.capture(h.frames[slot]); });
+    }
+
+    // back to the state of the n-th save before the last one, 0 for the last one itself,
+    // writes since then are dropped along with the frames rolled back
+    void restore(size_t n = 0) {
+        assert(n <= count_ && "Not that many frames");
+        each_history([](auto& h) {
+            h.capture(h.scratch);
+            h.apply(h.scratch);
+        });
+        for (; n != 0; --n, --count_) {
+            const auto slot = newest();
+            each_history([&](auto& h) { h.apply(h.frames[slot]); });
+        }
+    }
+
+    // how many saves there are to go back over
+    [[nodiscard]] size_t size() const { return count_; }
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+
+private:
+    size_t capacity_;
+    size_t head_{};
+    size_t count_{};
+    history<entity_type> entities_;
+    std::tuple<history<Type>...> pools_;
+
+};
+
+}
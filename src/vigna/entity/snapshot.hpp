@@ -0,0 +1,277 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <future>
+#include <istream>
+#include <ostream>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "registry.hpp"
+
+namespace vigna {
+
+// archives over std streams, anything with the same write or read member takes their place,
+// payloads that are not trivially copyable are handed to archive(value) one at a time.
+// read throws when it cannot fill the whole block, the loaders count on it to stop at a truncated archive
+class stream_output_archive {
+public:
+    explicit stream_output_archive(std::ostream& os) : os_(&os) {}
+
+    void write(const void* data, size_t size) {
+        os_->write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+private:
+    std::ostream* os_;
+
+};
+
+class stream_input_archive {
+public:
+    explicit stream_input_archive(std::istream& is) : is_(&is) {}
+
+    void read(void* data, size_t size) {
+        is_->read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(is_->gcount()) != size)
+            throw std::runtime_error("stream_input_archive: truncated archive");
+    }
+
+private:
+    std::istream* is_;
+
+};
+
+// writes the entity pool and the pools asked for, each as a header, its packed entities and its payload,
+// in the byte order of the host
+template <class Registry>
+class basic_snapshot {
+    using entity_type = typename Registry::entity_type;
+
+    template <class Archive, class V>
+    static void put(Archive& ar, const V& value) { ar.write(std::addressof(value), sizeof(V)); }
+
+public:
+    using registry_type = Registry;
+
+    explicit basic_snapshot(const Registry& reg) : reg_(&reg) {}
+
+    // dead entities are kept, so that versions survive the trip
+    template <class Archive>
+    const basic_snapshot& entities(Archive& ar) const {
+        const auto& pool = *reg_->template assure<entity_type>();
+        const uint64_t alive = pool.size();
+        const uint64_t total = alive + pool.cemetery_size();
+        put(ar, alive);
+        put(ar, total);
+        ar.write(pool.data(), total * sizeof(entity_type));
+        return *this;
+    }
+
+    // the pool of T keyed by its type hash, trivially copyable payloads are written in one block
+    template <class T, class Archive>
+    const basic_snapshot& get(Archive& ar) const {
+        const auto* pool = reg_->template assure<T>();
+        const uint64_t size = pool ? pool->size() : 0;
+        put(ar, static_cast<uint64_t>(Registry::template type_hash<T>()));
+        put(ar, size);
+        if (size == 0) return *this;
+
+        ar.write(pool->data(), size * sizeof(entity_type));
+        if constexpr (!std::is_void_v<typename std::decay_t<decltype(*pool)>::value_type>) {
+            if constexpr (std::is_trivially_copyable_v<T>)
+                ar.write(std::addressof(*pool->cbegin()), size * sizeof(T));
+            else for (auto&& i : pool->reach()) ar(i);
+        }
+        return *this;
+    }
+
+private:
+    const Registry* reg_;
+
+};
+
+// reads back what basic_snapshot wrote, in the same order, each pool is assigned in bulk
+// and has its sparse pages rebuilt in a single pass
+//
+// throws std::runtime_error on a pool out of order or a size that cannot be, and lets through what
+// the archive throws; the pool being read is then left as it was, those read before it are not rolled back
+template <class Registry>
+class basic_snapshot_loader {
+    using entity_type = typename Registry::entity_type;
+    using traits = entity_traits<entity_type>;
+    using alloc_traits = std::allocator_traits<typename Registry::allocator_type>;
+
+    static constexpr size_t chunk_size = (1 << 20) / sizeof(entity_type);
+
+    template <class Archive, class V>
+    static V take(Archive& ar) {
+        V value;
+        ar.read(std::addressof(value), sizeof(V));
+        return value;
+    }
+
+    // no more entities than there are ids
+    static void check_size(uint64_t size) {
+        if (size > static_cast<uint64_t>(traits::id_max) + 1)
+            throw std::runtime_error("basic_snapshot_loader: corrupt archive, size out of range");
+    }
+
+    // in chunks, so that a size out of a corrupt archive fails on the read before it is allocated whole
+    template <class Archive>
+    auto read_entities(Archive& ar, size_t size) {
+        std::vector<entity_type, typename alloc_traits::template rebind_alloc<entity_type>> buf(reg_->get_allocator());
+        for (size_t done = 0; done < size;) {
+            const auto n = std::min(size - done, chunk_size);
+            buf.resize(done + n);
+            ar.read(buf.data() + done, n * sizeof(entity_type));
+            done += n;
+        }
+        return buf;
+    }
+
+public:
+    using registry_type = Registry;
+
+    explicit basic_snapshot_loader(Registry& reg) : reg_(&reg) {}
+
+    template <class Archive>
+    basic_snapshot_loader& entities(Archive& ar) {
+        const auto alive = take<Archive, uint64_t>(ar);
+        const auto total = take<Archive, uint64_t>(ar);
+        check_size(total);
+        if (alive > total) throw std::runtime_error("basic_snapshot_loader: corrupt archive, more alive than total");
+        auto buf = read_entities(ar, total);
+        reg_->template assure<entity_type>().assign(buf.data(), buf.data() + buf.size(), alive);
+        return *this;
+    }
+
+    template <class T, class Archive>
+    basic_snapshot_loader& get(Archive& ar) {
+        if (take<Archive, uint64_t>(ar) != Registry::template type_hash<T>())
+            throw std::runtime_error("basic_snapshot_loader: pools read out of order");
+        const auto size = take<Archive, uint64_t>(ar);
+        check_size(size);
+        auto buf = read_entities(ar, size);
+        auto first = buf.data(), last = buf.data() + buf.size();
+        auto& pool = reg_->template assure<T>();
+
+        if constexpr (std::is_void_v<typename std::decay_t<decltype(pool)>::value_type>) {
+            pool.assign(first, last);
+        } else if constexpr (std::is_trivially_copyable_v<T>) {
+            // raw memory, as T need not be default constructible
+            using value_alloc_traits = typename alloc_traits::template rebind_traits<T>;
+            typename value_alloc_traits::allocator_type alloc{reg_->get_allocator()};
+            auto release = [&](T* p) { value_alloc_traits::deallocate(alloc, p, size); };
+            std::unique_ptr<T, decltype(release)> values{size ? value_alloc_traits::allocate(alloc, size) : nullptr, release};
+            ar.read(values.get(), size * sizeof(T));
+            pool.assign(first, last, values.get());
+        } else {
+            std::vector<T, typename alloc_traits::template rebind_alloc<T>> values(reg_->get_allocator());
+            values.reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                T value{};
+                ar(value);
+                values.push_back(std::move(value));
+            }
+            pool.assign(first, last, std::make_move_iterator(values.begin()));
+        }
+        return *this;
+    }
+
+private:
+    Registry* reg_;
+
+};
+
+// writes the pools asked for on a thread of its own in the format of basic_snapshot, in chunks, so that
+// basic_snapshot_loader reads it back; the archive is moved to that thread and has to stay usable there.
+// write takes a registry snapshot, see basic_registry::snapshot, and the thread reads the pools it shares,
+// so nothing is copied on the calling thread, the registry copies a pool on its first write while the
+// thread still holds it. the last holder may release a pool on that thread, the allocator has to allow it
+template <class Registry, class Archive>
+class basic_async_snapshot {
+    using entity_type = typename Registry::entity_type;
+    using snapshot_type = basic_registry_snapshot<Registry>;
+    using part_type = void (*)(const snapshot_type&, Archive&);
+
+    static constexpr size_t chunk_size = 1 << 20;
+
+    template <class V>
+    static void put(Archive& ar, const V& value) { ar.write(std::addressof(value), sizeof(V)); }
+
+    static void put_chunked(Archive& ar, const void* data, size_t size) {
+        for (auto* p = static_cast<const char*>(data); size != 0;) {
+            const auto n = std::min(size, chunk_size);
+            ar.write(p, n);
+            p += n, size -= n;
+        }
+    }
+
+public:
+    using registry_type = Registry;
+    using archive_type = Archive;
+
+    explicit basic_async_snapshot(Registry& reg) : reg_(&reg) {}
+
+    basic_async_snapshot& entities() {
+        parts_.push_back([](const snapshot_type& snap, Archive& ar) {
+            const auto& pool = snap.entities();
+            const uint64_t alive = pool.size();
+            const uint64_t total = alive + pool.cemetery_size();
+            put(ar, alive);
+            put(ar, total);
+            put_chunked(ar, pool.data(), total * sizeof(entity_type));
+        });
+        return *this;
+    }
+
+    template <class T>
+    basic_async_snapshot& get() {
+        parts_.push_back([](const snapshot_type& snap, Archive& ar) {
+            using value_type = typename Registry::template storage_for_type<T>::value_type;
+            const auto* pool = snap.template assure<T>();
+            const uint64_t size = pool ? pool->size() : 0;
+            put(ar, static_cast<uint64_t>(Registry::template type_hash<T>()));
+            put(ar, size);
+            if (size == 0) return;
+            put_chunked(ar, pool->data(), size * sizeof(entity_type));
+            if constexpr (!std::is_void_v<value_type>) {
+                if constexpr (std::is_trivially_copyable_v<T>)
+                    put_chunked(ar, std::addressof(*pool->cbegin()), size * sizeof(T));
+                else for (auto&& i : pool->reach()) ar(i);
+            }
+        });
+        return *this;
+    }
+
+    // hands what was asked for so far, as the registry is now, to a new thread, and is left empty for the next one
+    std::future<void> write(Archive ar) {
+        return write(std::move(ar), [] {});
+    }
+
+    // done runs on the writing thread once everything is written
+    template <class Fn>
+    std::future<void> write(Archive ar, Fn done) {
+        return std::async(std::launch::async, [ar = std::move(ar), snap = reg_->snapshot(), parts = std::exchange(parts_, {}), done = std::move(done)]() mutable {
+            for (auto&& part : parts) part(snap, ar);
+            done();
+        });
+    }
+
+private:
+    Registry* reg_;
+    std::vector<part_type> parts_;
+
+};
+
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "entity.hpp"
+#include "guard.hpp"
 
 #include <vector>
 #include <memory>
@@ -15,8 +16,55 @@
 
 namespace vigna {
 
+namespace detail {
+
+// builds a pool in memory of its allocator through construct, as copy constructors of pools are not public;
+// allocate_shared would also pass the allocator twice to uses-allocator aware allocators (e.g. pmr)
+template <class Pool, class Alloc, class Construct>
+std::shared_ptr<Pool> make_pool(const Alloc& alloc, Construct&& construct) {
+    using pool_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Pool>;
+    using pool_alloc_traits = std::allocator_traits<pool_alloc>;
+    pool_alloc palloc{alloc};
+    auto* ptr = pool_alloc_traits::allocate(palloc, 1);
+    construct(static_cast<void*>(ptr));
+    return std::shared_ptr<Pool>{ptr, [palloc](Pool* p) mutable {
+        p->~Pool();
+        pool_alloc_traits::deallocate(palloc, p, 1);
+    }, palloc};
+}
+
+}
+
+// where the memory of a pool goes, capacities count elements and bytes include the slack
+struct pool_memory_stats {
+    size_t sparse_pages{};        // pages allocated, VIGNA_SPARSE_PAGE entries each
+    size_t sparse_page_bytes{};
+    size_t sparse_table_bytes{};  // the array of page pointers, null ones included
+    size_t sparse_used{};         // entries pointing into the packed array
+    size_t sparse_lonely_pages{}; // pages kept for a single entity
+    size_t packed_size{};
+    size_t packed_capacity{};
+    size_t packed_bytes{};
+    size_t payload_size{};
+    size_t payload_capacity{};
+    size_t payload_bytes{};
+    size_t signal_bytes{};        // listeners of the signal mixin
+
+    // share of the allocated sparse entries in use, low when a few high ids hold whole pages
+    [[nodiscard]] double sparse_occupancy() const {
+        return sparse_pages ? static_cast<double>(sparse_used) / static_cast<double>(sparse_pages * VIGNA_SPARSE_PAGE) : 1.;
+    }
+
+    [[nodiscard]] size_t total_bytes() const {
+        return sparse_page_bytes + sparse_table_bytes + packed_bytes + payload_bytes + signal_bytes;
+    }
+};
+
 template <class T, class Alloc = std::allocator<T>>
 class basic_sparse_set {
+    template <class, class...>
+    friend class basic_rollback;
+
     using traits = entity_traits<T>;
     static_assert(std::is_same_v<typename traits::entity_type, T>);
     static_assert(sizeof(typename traits::value_type) == sizeof(T));
@@ -25,16 +73,26 @@ class basic_sparse_set {
     using id_type = typename traits::id_type;
     using version_type = typename traits::version_type;
 
-    static constexpr size_t sparse_page_size = VIGNA_SPARSE_PAGE;
-    struct sparse_page_deleter : private Alloc { void operator()(entity_value* ptr) {
-        Alloc::deallocate(reinterpret_cast<typename alloc_traits::pointer>(ptr), sparse_page_size);
-    }};
-    using sparse_page = std::unique_ptr<entity_value[], sparse_page_deleter>;
-
     using alloc_traits = std::allocator_traits<Alloc>;
     static_assert(std::is_same_v<typename alloc_traits::value_type, T>);
+
+    static constexpr size_t sparse_page_size = VIGNA_SPARSE_PAGE;
+    using page_alloc = typename alloc_traits::template rebind_alloc<entity_value>;
+    using page_alloc_traits = std::allocator_traits<page_alloc>;
+    struct sparse_page_deleter : private page_alloc {
+        sparse_page_deleter() = default;
+        explicit sparse_page_deleter(const page_alloc& alloc) : page_alloc(alloc) {}
+        void operator()(entity_value* ptr) {
+            page_alloc_traits::deallocate(*this, ptr, sparse_page_size);
+        }
+    };
+    using sparse_page = std::unique_ptr<entity_value[], sparse_page_deleter>;
     using sparse_container = std::vector<sparse_page, typename alloc_traits::template rebind_alloc<sparse_page>>;
     using packed_container = std::vector<T, Alloc>;
+    using dirty_container = std::vector<uint64_t, typename alloc_traits::template rebind_alloc<uint64_t>>;
+
+    // rows written since rollback last looked, one bit per dirty_rows of them, nothing is kept until it asks
+    static constexpr size_t dirty_rows = 16;
 
     static constexpr id_type id(const T& entity) { return traits::id(entity); }
     static constexpr version_type version(const T& entity) { return traits::version(entity); }
@@ -45,9 +103,10 @@ class basic_sparse_set {
 
     void sparse_emplace(id_type id, entity_value index) {
         auto [i, j] = sparse_bise(id);
-        if (i >= sparse_.size()) sparse_.resize(i + 1);
+        page_alloc alloc{packed_.get_allocator()}; // pages come from the same, possibly stateful, allocator
+        while (i >= sparse_.size()) sparse_.emplace_back(nullptr, sparse_page_deleter{alloc});
         if (sparse_[i] == nullptr) {
-            sparse_[i].reset(reinterpret_cast<entity_value*>(packed_.get_allocator().allocate(sparse_page_size)));
+            sparse_[i].reset(page_alloc_traits::allocate(alloc, sparse_page_size));
             std::uninitialized_fill_n(sparse_[i].get(), sparse_page_size, null); // as we have the useful 'null', instead of 'null_index'
         }
         sparse_[i][j] = index;
@@ -69,8 +128,24 @@ class basic_sparse_set {
     }
 
 protected:
+    void mark_dirty(size_t row) {
+        if (!tracked_) return;
+        const auto block = row / dirty_rows;
+        if (block / 64 >= dirty_.size()) dirty_.resize(block / 64 + 1);
+        dirty_[block / 64] |= uint64_t{1} << block % 64;
+    }
+    void mark_dirty() { all_dirty_ = tracked_; }
+
+    // the structure of the pool is about to change, see access_tracker
+    [[nodiscard]] auto changing() const {
+        assert_writable();
+        return tracker_.write();
+    }
+
     virtual void swap_and_pop(size_t index) {
         assert(index < packed_.size());
+        auto change = changing();
+        mark_dirty(index);
         isolate(id(packed_[index]));
         if (index != packed_.size() - 1) {
             sparse_at(id(packed_.back())) = static_cast<entity_value>(index);
@@ -80,13 +155,65 @@ protected:
     }
 
     virtual entity_value find_index(const T& value) const {
+        auto reading = tracker_.read();
         auto [i, j] = sparse_bise(id(value));
         if (i < sparse_.size() && sparse_[i]) return sparse_[i][j];
         return null;
     }
 
+    // replaces the whole packed array and indexes it in a single pass, storages pair it with their payload
+    void assign_packed(const T* first, const T* last) {
+        auto change = changing();
+        mark_dirty();
+        for (auto&& i : packed_)
+            isolate(id(i));
+        packed_.assign(first, last);
+        if (!packed_.empty())
+            sparse_.reserve(sparse_bise(id(*std::max_element(packed_.begin(), packed_.end(), [](auto&& a, auto&& b) { return id(a) < id(b); }))).first + 1);
+        for (size_t i = 0; i < packed_.size(); ++i)
+            sparse_emplace(id(packed_[i]), static_cast<entity_value>(i));
+    }
+
+    // moves what was at order[i] to i, for every i, swap_extra(a, b) swaps what storages keep beside
+    // the packed array; the sparse entries are redone once at the end. order is left as 0, 1, ...
+    template <class Order, class Swap>
+    void permute(Order& order, Swap&& swap_extra) {
+        assert(order.size() == packed_.size());
+        auto change = changing();
+        mark_dirty();
+        for (size_t i = 0; i < order.size(); ++i) {
+            auto curr = i;
+            for (auto next = order[curr]; next != i; curr = next, next = order[curr]) {
+                std::swap(packed_[curr], packed_[next]);
+                swap_extra(curr, next);
+                order[curr] = curr;
+            }
+            order[curr] = curr;
+        }
+        for (size_t i = 0; i < packed_.size(); ++i)
+            sparse_at(id(packed_[i])) = static_cast<entity_value>(i);
+    }
+
+    // deep copy for clone, the guard is not copied; the rows written so far are, so that a pool the registry
+    // swaps for its copy keeps them
+    basic_sparse_set(const basic_sparse_set& other)
+        : sparse_(typename sparse_container::allocator_type{other.get_allocator()}), packed_(other.packed_, other.get_allocator()),
+          dirty_(other.dirty_, typename dirty_container::allocator_type{other.get_allocator()}),
+          tracked_(other.tracked_), all_dirty_(other.all_dirty_) {
+        page_alloc alloc{packed_.get_allocator()};
+        sparse_.reserve(other.sparse_.size());
+        for (auto&& page : other.sparse_) {
+            sparse_.emplace_back(nullptr, sparse_page_deleter{alloc});
+            if (page == nullptr) continue;
+            sparse_.back().reset(page_alloc_traits::allocate(alloc, sparse_page_size));
+            std::uninitialized_copy_n(page.get(), sparse_page_size, sparse_.back().get());
+        }
+    }
+
     void swap_elements_index(size_t a, size_t b) {
         assert(a < packed_.size() && b < packed_.size());
+        auto change = changing();
+        mark_dirty(a), mark_dirty(b);
         std::swap(sparse_at(id(packed_[a])), sparse_at(id(packed_[b])));
         std::swap(packed_[a], packed_[b]);
     }
@@ -100,18 +227,45 @@ public:
     using const_reverse_iterator = reverse_iterator;
 
     basic_sparse_set() = default;
-    basic_sparse_set(const basic_sparse_set&) = delete;
+    explicit basic_sparse_set(const Alloc& alloc)
+        : sparse_(typename sparse_container::allocator_type{alloc}), packed_(alloc), dirty_(typename dirty_container::allocator_type{alloc}) {}
     basic_sparse_set(basic_sparse_set&&) = default;
     basic_sparse_set& operator=(const basic_sparse_set&) = delete;
     basic_sparse_set& operator=(basic_sparse_set&&) = default;
 
     virtual ~basic_sparse_set() = default;
 
+    // whether clone can copy the pool, false for components that cannot be copied
+    [[nodiscard]] virtual bool cloneable() const { return true; }
+
+    // a copy of the pool of the same dynamic type, without signal connections or owner; null when not cloneable
+    [[nodiscard]] virtual std::shared_ptr<basic_sparse_set> clone() const {
+        return detail::make_pool<basic_sparse_set>(get_allocator(), [this](void* p) { ::new (p) basic_sparse_set(*this); });
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const { return packed_.get_allocator(); }
+
     [[nodiscard]] virtual size_t size() const { return packed_.size(); }
     [[nodiscard]] virtual bool empty() const { return packed_.empty(); }
 
     [[nodiscard]] size_t capacity() const { return packed_.capacity(); }
     void reserve(size_t size) { packed_.reserve(size); }
+
+    // walks the packed array once to count entities per page
+    [[nodiscard]] virtual pool_memory_stats memory_stats() const {
+        pool_memory_stats stats;
+        std::vector<uint32_t> per_page(sparse_.size());
+        for (auto&& e : packed_) ++per_page[sparse_bise(id(e)).first];
+        for (size_t i = 0; i < sparse_.size(); ++i)
+            if (sparse_[i]) stats.sparse_pages++, stats.sparse_lonely_pages += per_page[i] == 1;
+        stats.sparse_page_bytes = stats.sparse_pages * sparse_page_size * sizeof(entity_value);
+        stats.sparse_table_bytes = sparse_.capacity() * sizeof(sparse_page);
+        stats.sparse_used = packed_.size();
+        stats.packed_size = packed_.size();
+        stats.packed_capacity = packed_.capacity();
+        stats.packed_bytes = packed_.capacity() * sizeof(T);
+        return stats;
+    }
     void shrink_to_fit() { packed_.shrink_to_fit(); }
 
     std::pair<iterator, bool> emplace(id_type id, version_type version) {
@@ -124,7 +278,9 @@ public:
     std::pair<iterator, bool> push(const T& value) {
         if (auto it = find(value); it != end())
             return {it, false};
+        auto change = changing();
         auto index = packed_.size();
+        mark_dirty(index);
         packed_.push_back(value);
         sparse_emplace(id(value), index);
         return {begin(index), true};
@@ -147,6 +303,8 @@ public:
     }
 
     virtual void clear() {
+        auto change = changing();
+        mark_dirty();
         for (auto&& i : packed_)
             isolate(id(i));
         packed_.clear();
@@ -158,7 +316,7 @@ public:
         return false;
     }
 
-    size_t pop(iterator first, iterator last) {
+    virtual size_t pop(iterator first, iterator last) {
         return std::count_if(first, last, [&](auto&&e) { return pop(e); });
     }
 
@@ -187,6 +345,7 @@ public:
     // ReSharper restore CppHiddenFunction
 
     const T& operator[](size_t i) const { return packed_[i]; }
+    [[nodiscard]] const T* data() const { return packed_.data(); }
 
     [[nodiscard]] virtual size_t index(const const_iterator& it) const { return std::distance(begin(), it); }
     [[nodiscard]] virtual size_t index(const T& entity) const { return find_index(entity); }
@@ -204,19 +363,26 @@ public:
 
     void bump(const entity_type& entity) {
         assert(entity != null);
-        auto index = find_index(entity);
+        auto index = basic_sparse_set::find_index(entity); // also reaches dead entities of an entity storage
+        assert(index != null);
+        auto change = changing();
+        mark_dirty(index);
         traits::reversion(packed_[index], version(entity));
     }
 
     void sort(const std::function<bool(T, T)>& camp = [](const T& a, const T& b) {
         return id(a) < id(b);
     }) {
+        auto change = changing();
+        mark_dirty();
         std::sort(packed_.begin(), packed_.end(), camp);
         for (size_t i = 0; i < packed_.size(); ++i)
             sparse_at(id(packed_[i])) = i;
     }
 
     void partition(const std::function<bool(T)>& pre) {
+        auto change = changing();
+        mark_dirty();
         std::partition(packed_.begin(), packed_.end(), pre);
         for (size_t i = 0; i < packed_.size(); ++i)
             sparse_at(id(packed_[i])) = i;
@@ -233,10 +399,38 @@ public:
     }
 
     virtual void bind(void*) {} // signal bind, see mixin
+    virtual void take_signals(basic_sparse_set&) {} // listeners of a pool of the same type move here, see mixin
+
+    // set while a registry snapshot shares the pool, writes then have to go through the registry,
+    // which copies the pool first; copies start writable
+    [[nodiscard]] bool read_only() const { return read_only_; }
+    void read_only(bool value) { read_only_ = value; }
+
+    void assert_writable() const {
+        VIGNA_ASSERT_WRITABLE(guard());
+        assert(!read_only_ && "Pool written after a snapshot took it, get it from the registry again");
+    }
+
+    [[nodiscard]] pool_guard& guard() const {
+#ifdef VIGNA_POOL_GUARD
+        return guard_;
+#else
+        static pool_guard dummy{};
+        return dummy;
+#endif
+    }
 
 private:
     sparse_container sparse_;
     packed_container packed_;
+    bool read_only_{};
+    access_tracker tracker_;
+    mutable dirty_container dirty_;
+    mutable bool tracked_{};
+    mutable bool all_dirty_{};
+#ifdef VIGNA_POOL_GUARD
+    mutable pool_guard guard_;
+#endif
 
 };
 
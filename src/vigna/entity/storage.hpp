@@ -4,22 +4,94 @@
 
 #pragma once
 
+#include <tuple>
+#include <utility>
+
 #include "sparse_set.hpp"
+#include "component.hpp"
 #include "vigna/range/view.hpp"
 
 namespace vigna {
 
+// walks the packed entities and their payload together from two base pointers and an index,
+// so that it stays random access and costs three words to copy. it yields tuples of references,
+// so it serves algorithms that read or write in place (parallel for_each, find, chunked dispatch)
+// but not those that move elements around, std::sort included: see basic_storage::sort
+template <class Entity, class T>
+class storage_iterator {
+    template <class, class>
+    friend class storage_iterator;
+
+public:
+    using value_type = std::tuple<const Entity&, T&>;
+    using pointer = range::input_iterator_pointer<value_type>;
+    using reference = value_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+
+    storage_iterator() = default;
+    storage_iterator(const Entity* entities, T* payload, difference_type index)
+        : entities_(entities), payload_(payload), index_(index) {}
+
+    template <class U, class = std::enable_if_t<std::is_same_v<const U, T>>>
+    storage_iterator(const storage_iterator<Entity, U>& other)
+        : entities_(other.entities_), payload_(other.payload_), index_(other.index_) {}
+
+    reference operator*() const { return {entities_[index_], payload_[index_]}; }
+    pointer operator->() const { return pointer{**this}; }
+    reference operator[](difference_type n) const { return {entities_[index_ + n], payload_[index_ + n]}; }
+
+    storage_iterator& operator++() { return ++index_, *this; }
+    storage_iterator operator++(int) { auto cp = *this; return ++index_, cp; }
+    storage_iterator& operator--() { return --index_, *this; }
+    storage_iterator operator--(int) { auto cp = *this; return --index_, cp; }
+    storage_iterator& operator+=(difference_type n) { return index_ += n, *this; }
+    storage_iterator& operator-=(difference_type n) { return index_ -= n, *this; }
+    storage_iterator operator+(difference_type n) const { return {entities_, payload_, index_ + n}; }
+    storage_iterator operator-(difference_type n) const { return {entities_, payload_, index_ - n}; }
+    friend storage_iterator operator+(difference_type n, const storage_iterator& it) { return it + n; }
+
+    difference_type operator-(const storage_iterator& o) const { return index_ - o.index_; }
+    bool operator==(const storage_iterator& o) const { return index_ == o.index_; }
+    bool operator!=(const storage_iterator& o) const { return index_ != o.index_; }
+    bool operator<(const storage_iterator& o) const { return index_ < o.index_; }
+    bool operator>(const storage_iterator& o) const { return index_ > o.index_; }
+    bool operator<=(const storage_iterator& o) const { return index_ <= o.index_; }
+    bool operator>=(const storage_iterator& o) const { return index_ >= o.index_; }
+
+    [[nodiscard]] const Entity& entity() const { return entities_[index_]; }
+    [[nodiscard]] T& value() const { return payload_[index_]; }
+    [[nodiscard]] difference_type index() const { return index_; }
+
+private:
+    const Entity* entities_{};
+    T* payload_{};
+    difference_type index_{};
+
+};
+
 template <class Entity, class T, class Alloc = std::allocator<T>, class = void>
 class basic_storage : public basic_sparse_set<Entity, typename std::allocator_traits<Alloc>::template rebind_alloc<Entity>> {
+    template <class, class...>
+    friend class basic_rollback;
+
     using alloc_traits = std::allocator_traits<Alloc>;
     static_assert(std::is_same_v<typename alloc_traits::value_type, T>);
 
-    using container_type = std::vector<T, Alloc>;
+    // the payload alone may live elsewhere, see component_traits, entities and sparse pages stay with Alloc
+    using payload_allocator = detail::component_allocator_t<T, Alloc>;
+    using container_type = std::vector<T, payload_allocator>;
+
+    static payload_allocator make_payload_allocator(const Alloc& alloc) {
+        if constexpr (std::is_constructible_v<payload_allocator, const Alloc&>) return payload_allocator(alloc);
+        else return payload_allocator{};
+    }
 
 protected:
     using base_type = basic_sparse_set<Entity, typename std::allocator_traits<Alloc>::template rebind_alloc<Entity>>;
 
     void swap_and_pop(size_t index) override {
+        auto change = base_type::changing();
         base_type::swap_and_pop(index);
         if (index != size() - 1)
             std::swap(payload_[index], payload_.back());
@@ -28,6 +100,17 @@ protected:
 
     using base_type::find_index;
 
+    // the allocator goes along explicitly, select_on_container_copy_construction gives pmr the default resource
+    basic_storage(const basic_storage& other)
+        : base_type(other), payload_(other.payload_, other.payload_.get_allocator()) {}
+
+private:
+    // a writable iterator to one row, the row counts as written
+    auto at(size_t index) {
+        base_type::mark_dirty(index);
+        return payload_.begin() + index;
+    }
+
 public:
     using allocator_type = Alloc;
     using entity_type = Entity;
@@ -37,21 +120,48 @@ public:
     using const_iterator = typename container_type::const_iterator;
     using reverse_iterator = typename container_type::reverse_iterator;
     using const_reverse_iterator = typename container_type::const_reverse_iterator;
+    using each_iterator = storage_iterator<Entity, T>;
+    using const_each_iterator = storage_iterator<Entity, const T>;
 
     basic_storage() = default;
+    explicit basic_storage(const Alloc& alloc)
+        : base_type(typename base_type::allocator_type{alloc}), payload_(make_payload_allocator(alloc)) {}
+    basic_storage(basic_storage&&) = default;
+    basic_storage& operator=(basic_storage&&) = default;
+
+    [[nodiscard]] bool cloneable() const override { return std::is_copy_constructible_v<T>; }
+
+    [[nodiscard]] std::shared_ptr<base_type> clone() const override {
+        if constexpr (std::is_copy_constructible_v<T>) {
+            return detail::make_pool<basic_storage>(get_allocator(), [this](void* p) { ::new (p) basic_storage(*this); });
+        } else {
+            assert(false && "Pool of a type that cannot be copied");
+            return nullptr;
+        }
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const { return allocator_type{base_type::get_allocator()}; }
 
     [[nodiscard]] size_t size() const override { return payload_.size(); }
     [[nodiscard]] bool empty() const override { return payload_.empty(); }
 
+    [[nodiscard]] pool_memory_stats memory_stats() const override {
+        auto stats = base_type::memory_stats();
+        stats.payload_size = payload_.size();
+        stats.payload_capacity = payload_.capacity();
+        stats.payload_bytes = payload_.capacity() * sizeof(T);
+        return stats;
+    }
+
     template<class... Args>
     std::pair<iterator, bool> emplace(Entity entity, Args&&... args) {
         assert(entity != null && base_type::size() == size());
+        auto change = base_type::changing();
         if (auto [it, success] = base_type::push(entity); success) {
             payload_.emplace_back(std::forward<Args>(args)...);
-            return {end() - 1, true};
+            return {at(size() - 1), true};
         } else {
-            auto index = base_type::index(it);
-            return {payload_.begin() + index, false};
+            return {at(base_type::index(it)), false};
         }
     }
 
@@ -88,7 +198,7 @@ public:
         std::enable_if_t<std::is_constructible_v<Entity, decltype(*std::declval<First_>())>, std::void_t<decltype(*++std::declval<First_>() != *std::declval<Last_>())>>>
     iterator insert(First_&& first, Last_&& last, const T& value) {
         for (auto it = first; it != last; ++it) emplace(*it, value);
-        return end() - 1;
+        return at(size() - 1);
     }
 
     template <class First_, class Last_, class CFirst_, class = std::enable_if_t<
@@ -97,7 +207,15 @@ public:
         std::void_t<decltype(*++std::declval<First_>() != *std::declval<Last_>(), *++std::declval<CFirst_>())>>>
     iterator insert(First_&& first, Last_&& last, CFirst_ values) {
         for (auto it = first; it != last; ++it, ++values) emplace(*it, *values);
-        return end() - 1;
+        return at(size() - 1);
+    }
+
+    // replaces the content with the entities in [first, last) and as many values, in one pass
+    template <class It>
+    void assign(const Entity* first, const Entity* last, It values) {
+        auto change = base_type::changing();
+        base_type::assign_packed(first, last);
+        payload_.assign(values, std::next(values, last - first));
     }
 
     // ReSharper disable once CppHidingFunction
@@ -112,14 +230,15 @@ public:
     }
 
     void clear() override {
+        auto change = base_type::changing();
         base_type::clear();
         payload_.clear();
     }
 
     iterator find(const Entity& entity) {
         if (auto index = find_index(entity); index != null)
-            return begin(index);
-        return end();
+            return at(index);
+        return payload_.end();
     }
     // ReSharper disable once CppHidingFunction
     const_iterator find(const Entity& entity) const {
@@ -129,8 +248,10 @@ public:
     }
 
     T& get(const Entity& entity) {
+        base_type::assert_writable();
         auto index = find_index(entity);
         assert(index != null && "Invalid entity!");
+        base_type::mark_dirty(index);
         return payload_[index];
     }
     const T& get(const Entity& entity) const {
@@ -148,14 +269,46 @@ public:
 
     using base_type::contains;
 
-    auto reach() { return payload_ | view::all; }
+    auto reach() { return base_type::mark_dirty(), payload_ | view::all; }
     auto reach() const { return payload_ | view::all; }
 
-    auto each() { return view::pack(*this, payload_); }
-    auto each() const { return view::pack(*this, payload_); }
+    auto each() {
+        base_type::assert_writable();
+        base_type::mark_dirty();
+        auto n = static_cast<std::ptrdiff_t>(size());
+        return range::subrange{each_iterator{base_type::data(), payload_.data(), 0}, each_iterator{base_type::data(), payload_.data(), n}};
+    }
+    auto each() const {
+        auto n = static_cast<std::ptrdiff_t>(size());
+        return range::subrange{const_each_iterator{base_type::data(), payload_.data(), 0}, const_each_iterator{base_type::data(), payload_.data(), n}};
+    }
+
+    // sorts entities and payload together, compare takes two values, or two (entity, value) tuples as each() gives
+    // when it cannot take values (generic lambdas get values);
+    // the order is worked out on indices and applied in one pass of swaps, the sparse array is redone after
+    template <class Compare>
+    void sort(Compare compare) {
+        auto change = base_type::changing();
+        using index_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<size_t>;
+        std::vector<size_t, index_alloc> order(size(), index_alloc{get_allocator()});
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        const auto* packed = base_type::data();
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if constexpr (std::is_invocable_r_v<bool, Compare&, const T&, const T&>)
+                return compare(std::as_const(payload_[a]), std::as_const(payload_[b]));
+            else
+                return compare(std::tuple<const Entity&, const T&>{packed[a], payload_[a]},
+                               std::tuple<const Entity&, const T&>{packed[b], payload_[b]});
+        });
+        base_type::permute(order, [this](size_t a, size_t b) {
+            using std::swap;
+            swap(payload_[a], payload_[b]);
+        });
+    }
 
     template<class...Fns, class = std::enable_if_t<(std::is_invocable_v<Fns, T> && ...)>>
     T& patch(const Entity& entity, Fns&&...f) {
+        base_type::assert_writable();
         auto& e = get(entity);
         (std::forward<Fns>(f)(e), ...);
         return e;
@@ -168,20 +321,20 @@ public:
     // }
 
     // ReSharper disable CppHidingFunction
-    T& front() { return payload_.front(); }
-    T& back() { return payload_.back(); }
+    T& front() { return *at(0); }
+    T& back() { return *at(size() - 1); }
     const T& front() const { return payload_.front(); }
     const T& back() const { return payload_.back(); }
 
-    iterator begin(size_t n = 0) { return payload_.begin() + n; }
+    iterator begin(size_t n = 0) { return base_type::mark_dirty(), payload_.begin() + n; }
     const_iterator begin(size_t n = 0) const { return payload_.begin() + n; }
-    iterator end() { return payload_.end(); }
+    iterator end() { return base_type::mark_dirty(), payload_.end(); }
     const_iterator end() const { return payload_.end(); }
     const_iterator cbegin(size_t n = 0) const { return payload_.cbegin() + n; }
     const_iterator cend() const { return payload_.cend(); }
-    reverse_iterator rbegin(size_t n = 0) { return payload_.rbegin() + n; }
+    reverse_iterator rbegin(size_t n = 0) { return base_type::mark_dirty(), payload_.rbegin() + n; }
     const_reverse_iterator rbegin(size_t n = 0) const { return payload_.rbegin() + n; }
-    reverse_iterator rend() { return payload_.rend(); }
+    reverse_iterator rend() { return base_type::mark_dirty(), payload_.rend(); }
     const_reverse_iterator rend() const { return payload_.rend(); }
     const_reverse_iterator crbegin(size_t n = 0) const { return payload_.crbegin() + n; }
     const_reverse_iterator crend() const { return payload_.crend(); }
@@ -201,6 +354,9 @@ private:
 
 template <class Entity, class Alloc>
 class basic_storage<Entity, Entity, Alloc> : public basic_sparse_set<Entity, Alloc> {
+    template <class, class...>
+    friend class basic_rollback;
+
     using traits = entity_traits<Entity>;
     static_assert(std::is_same_v<typename traits::entity_type, Entity>);
 
@@ -216,6 +372,7 @@ protected:
 
     void swap_and_pop(size_t index) override {
         assert(index < length_);
+        auto change = base_type::changing();
         if (index != --length_)
             swap_elements_index(index, length_);
         bump(traits::next_version((*this)[length_]));
@@ -228,6 +385,8 @@ protected:
 
     using base_type::swap_elements_index;
 
+    basic_storage(const basic_storage&) = default;
+
 public:
     using allocator_type = Alloc;
     using entity_type = Entity;
@@ -241,6 +400,12 @@ public:
     using base_type::basic_sparse_set;
 
     basic_storage() = default;
+    basic_storage(basic_storage&&) = default;
+    basic_storage& operator=(basic_storage&&) = default;
+
+    [[nodiscard]] std::shared_ptr<base_type> clone() const override {
+        return detail::make_pool<basic_storage>(base_type::get_allocator(), [this](void* p) { ::new (p) basic_storage(*this); });
+    }
 
     [[nodiscard]] size_t size() const override { return length_; }
     [[nodiscard]] bool empty() const override { return length_ == 0; }
@@ -255,6 +420,7 @@ public:
     [[nodiscard]] bool valid(entity_type entity) const { return contains(entity); }
 
     entity_type emplace() {
+        auto change = base_type::changing();
         assert(length_ < traits::id_max && "No more entity!");
         if (cemetery_empty()) base_type::emplace(length_, 0);
         return *begin(length_++);
@@ -262,6 +428,7 @@ public:
 
     // ReSharper disable once CppHidingFunction
     entity_type emplace(const entity_type& hint) {
+        auto change = base_type::changing();
         assert(hint != null && id(hint) <= base_type::size());
         if (id(hint) == base_type::size()) {
             base_type::push(hint); // must succeed
@@ -278,10 +445,19 @@ public:
         for (auto it = first; it != last; ++it) emplace(*it);
     }
 
+    // replaces the content with [first, last), of which the first length entities are alive
+    void assign(const entity_type* first, const entity_type* last, size_t length) {
+        assert(length <= static_cast<size_t>(last - first));
+        auto change = base_type::changing();
+        base_type::assign_packed(first, last);
+        length_ = length;
+    }
+
     using base_type::erase;
     using base_type::pop;
 
     void clear() override {
+        auto change = base_type::changing();
         base_type::clear();
         length_ = 0;
     }
@@ -326,6 +502,8 @@ class basic_storage<Entity, T, Alloc, VIGNA_ETO(T)> : public basic_sparse_set<En
 protected:
     using base_type = basic_sparse_set<Entity, typename std::allocator_traits<Alloc>::template rebind_alloc<Entity>>;
 
+    basic_storage(const basic_storage&) = default;
+
 public:
     using allocator_type = Alloc;
     using entity_type = Entity;
@@ -337,6 +515,16 @@ public:
     using typename base_type::const_reverse_iterator;
 
     basic_storage() = default;
+    explicit basic_storage(const Alloc& alloc)
+        : base_type(typename base_type::allocator_type{alloc}) {}
+    basic_storage(basic_storage&&) = default;
+    basic_storage& operator=(basic_storage&&) = default;
+
+    [[nodiscard]] std::shared_ptr<base_type> clone() const override {
+        return detail::make_pool<basic_storage>(get_allocator(), [this](void* p) { ::new (p) basic_storage(*this); });
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const { return allocator_type{base_type::get_allocator()}; }
 
     using base_type::size;
     using base_type::empty;
@@ -354,6 +542,11 @@ public:
         for (auto it = first; it != last; ++it) base_type::emplace(*it);
     }
 
+    template <class...Args>
+    void assign(const Entity* first, const Entity* last, Args&&...) {
+        base_type::assign_packed(first, last);
+    }
+
     using base_type::erase;
     using base_type::clear;
 
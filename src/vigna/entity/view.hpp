@@ -6,6 +6,7 @@
 
 #include <array>
 
+#include "guard.hpp"
 #include "vigna/range/view.hpp"
 #include "vigna/reflect/utility.hpp"
 
@@ -62,6 +63,21 @@ public:
         }
     }
 
+    // get pools are locked unique unless the view is const, exclude pools are always shared;
+    // views never lock on their own, VIGNA_TRACK_ACCESS catches systems racing without it, see access_tracker.
+    // the lock stays with the pools the view was made from, see basic_pool_lock for registry snapshots
+    [[nodiscard]] auto lock() const {
+        std::array<pool_guard*, Get + Exclude> guards{};
+        std::array<bool, Get + Exclude> unique{};
+        for (size_t i = 0; i < Get; ++i) {
+            guards[i] = get_[i] ? &get_[i]->guard() : nullptr;
+            unique[i] = !std::is_const_v<T>;
+        }
+        for (size_t i = 0; i < Exclude; ++i)
+            guards[Get + i] = exclude_[i] ? &exclude_[i]->guard() : nullptr;
+        return basic_pool_lock<Get + Exclude>{guards, unique};
+    }
+
     bool contains(const entity_type& entity) const {
         const auto f = [entity](auto&& p) { return p && p->contains(entity); };
         return index < Get &&
@@ -133,6 +149,7 @@ public:
     using base_type::end;
 
     using base_type::contains;
+    using base_type::lock;
 
     auto each() const {
         return view::transform(*this, [&](auto&& e) {
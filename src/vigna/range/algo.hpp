@@ -4,19 +4,67 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+#include <numeric>
+#include <optional>
 #include <algorithm>
+#include <functional>
 
 #include "range.hpp"
 #include "view.hpp"
+#include "execution.hpp"
 
 namespace vigna::range {
 
+namespace detail {
+
+// a parallel policy over a sized random access range, anything else runs in order
+template <class E, class R>
+constexpr bool parallel_v =
+    std::is_same_v<decltype(execution::policy_of(std::declval<E>())), execution::parallel_policy> &&
+    is_random_access_v<std::decay_t<decltype(begin(std::declval<R>()))>> && is_sized_range_v<R>;
+
+constexpr size_t default_grain = 1024;
+
+// [0, n) in k nearly even pieces
+struct chunks {
+    chunks(const execution::parallel_policy& policy, size_t n)
+        : n(n), k(std::clamp<size_t>(n / (policy.grain ? policy.grain : default_grain), 1, policy.executor().size() + 1)) {}
+
+    [[nodiscard]] size_t bound(size_t i) const { return i * (n / k) + std::min(i, n % k); }
+
+    // fn(chunk, first, last) across the pool
+    template <class Fn>
+    void run(const execution::parallel_policy& policy, Fn&& fn) const {
+        policy.executor().run(k, [&](size_t i) { fn(i, bound(i), bound(i + 1)); });
+    }
+
+    size_t n, k;
+};
+
+// searches stop at the next block once a result makes them pointless
+constexpr size_t search_block = 256;
+
+}
+
 constexpr struct for_each_t {
-    template <class R, class F, class P = identity>
+    template <class R, class F, class P = identity, class = is_range_t<R>>
     constexpr void operator()(R&& range, F&& func, P&& proj = {}) const {
         auto v = std::forward<R>(range) | view::transform(std::forward<P>(proj)) | view::common;
         std::for_each(begin(v), end(v), std::forward<F>(func));
     }
+    template <class E, class R, class F, class P = identity, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    void operator()(E&& policy, R&& range, F&& func, P&& proj = {}) const {
+        if constexpr (detail::parallel_v<E, R>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::transform(std::forward<P>(proj)) | view::common;
+            auto b = begin(v);
+            detail::chunks{p, static_cast<size_t>(end(v) - b)}.run(p, [&](size_t, size_t first, size_t last) {
+                std::for_each(b + first, b + last, std::ref(func));
+            });
+        } else (*this)(std::forward<R>(range), std::forward<F>(func), std::forward<P>(proj));
+    }
 } for_each{};
 
 constexpr struct for_each_n_t {
@@ -27,4 +75,191 @@ constexpr struct for_each_n_t {
     }
 } for_each_n{};
 
+// writes fn(x) for each element to out, returns the end of the output
+constexpr struct transform_t {
+    template <class R, class O, class F, class = is_range_t<R>>
+    constexpr O operator()(R&& range, O out, F&& func) const {
+        auto v = std::forward<R>(range) | view::common;
+        return std::transform(begin(v), end(v), out, std::forward<F>(func));
+    }
+    template <class E, class R, class O, class F, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    O operator()(E&& policy, R&& range, O out, F&& func) const {
+        if constexpr (detail::parallel_v<E, R> && is_random_access_v<O>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::common;
+            auto b = begin(v);
+            detail::chunks c{p, static_cast<size_t>(end(v) - b)};
+            c.run(p, [&](size_t, size_t first, size_t last) {
+                std::transform(b + first, b + last, out + first, std::ref(func));
+            });
+            return out + c.n;
+        } else return (*this)(std::forward<R>(range), out, std::forward<F>(func));
+    }
+} transform{};
+
+// folds tr(x) into init with red, red has to be associative as the chunks are folded apart
+constexpr struct transform_reduce_t {
+    template <class R, class T, class Red, class Tr, class = is_range_t<R>>
+    constexpr T operator()(R&& range, T init, Red&& red, Tr&& tr) const {
+        auto v = std::forward<R>(range) | view::common;
+        return std::transform_reduce(begin(v), end(v), std::move(init), std::forward<Red>(red), std::forward<Tr>(tr));
+    }
+    template <class E, class R, class T, class Red, class Tr, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    T operator()(E&& policy, R&& range, T init, Red&& red, Tr&& tr) const {
+        if constexpr (detail::parallel_v<E, R>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::common;
+            auto b = begin(v);
+            detail::chunks c{p, static_cast<size_t>(end(v) - b)};
+            if (c.n == 0) return init;
+            // no chunk is empty, so each starts from its first element and init is used once
+            std::vector<std::optional<T>> parts(c.k);
+            c.run(p, [&](size_t i, size_t first, size_t last) {
+                auto it = b + first;
+                T acc(tr(*it));
+                for (auto e = b + last; ++it != e;) acc = red(std::move(acc), tr(*it));
+                parts[i].emplace(std::move(acc));
+            });
+            for (auto&& i : parts) init = red(std::move(init), std::move(*i));
+            return init;
+        } else return (*this)(std::forward<R>(range), std::move(init), std::forward<Red>(red), std::forward<Tr>(tr));
+    }
+} transform_reduce{};
+
+constexpr struct reduce_t {
+    template <class R, class T, class Op = std::plus<>, class = is_range_t<R>>
+    constexpr T operator()(R&& range, T init, Op&& op = {}) const {
+        return transform_reduce(std::forward<R>(range), std::move(init), std::forward<Op>(op), identity{});
+    }
+    template <class E, class R, class T, class Op = std::plus<>, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    T operator()(E&& policy, R&& range, T init, Op&& op = {}) const {
+        return transform_reduce(policy, std::forward<R>(range), std::move(init), std::forward<Op>(op), identity{});
+    }
+} reduce{};
+
+constexpr struct count_if_t {
+    template <class R, class Pred, class = is_range_t<R>>
+    constexpr size_t operator()(R&& range, Pred&& pred) const {
+        return (*this)(execution::seq, std::forward<R>(range), std::forward<Pred>(pred));
+    }
+    template <class E, class R, class Pred, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    size_t operator()(E&& policy, R&& range, Pred&& pred) const {
+        return transform_reduce(policy, std::forward<R>(range), size_t{0}, std::plus<>{},
+            [&pred](auto&& x) -> size_t { return pred(std::forward<decltype(x)>(x)) ? 1 : 0; });
+    }
+} count_if{};
+
+// the first element accepted by pred, even when found in parallel
+constexpr struct find_if_t {
+    template <class R, class Pred, class = is_range_t<R>>
+    constexpr auto operator()(R&& range, Pred&& pred) const {
+        auto v = std::forward<R>(range) | view::common;
+        return std::find_if(begin(v), end(v), std::forward<Pred>(pred));
+    }
+    template <class E, class R, class Pred, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    auto operator()(E&& policy, R&& range, Pred&& pred) const {
+        if constexpr (detail::parallel_v<E, R>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::common;
+            auto b = begin(v);
+            detail::chunks c{p, static_cast<size_t>(end(v) - b)};
+            std::atomic<size_t> found{c.n};
+            c.run(p, [&](size_t, size_t first, size_t last) {
+                for (auto s = first; s < last && s < found.load(std::memory_order_relaxed); s += detail::search_block) {
+                    auto e = b + std::min(last, s + detail::search_block);
+                    if (auto it = std::find_if(b + s, e, std::ref(pred)); it != e) {
+                        auto i = static_cast<size_t>(it - b);
+                        for (auto curr = found.load(std::memory_order_relaxed);
+                             i < curr && !found.compare_exchange_weak(curr, i, std::memory_order_relaxed);) {}
+                        return;
+                    }
+                }
+            });
+            return b + found.load(std::memory_order_relaxed);
+        } else return (*this)(std::forward<R>(range), std::forward<Pred>(pred));
+    }
+} find_if{};
+
+constexpr struct any_of_t {
+    template <class R, class Pred, class = is_range_t<R>>
+    constexpr bool operator()(R&& range, Pred&& pred) const {
+        auto v = std::forward<R>(range) | view::common;
+        return std::any_of(begin(v), end(v), std::forward<Pred>(pred));
+    }
+    template <class E, class R, class Pred, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    bool operator()(E&& policy, R&& range, Pred&& pred) const {
+        if constexpr (detail::parallel_v<E, R>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::common;
+            auto b = begin(v);
+            std::atomic<bool> hit{};
+            detail::chunks{p, static_cast<size_t>(end(v) - b)}.run(p, [&](size_t, size_t first, size_t last) {
+                for (auto s = first; s < last && !hit.load(std::memory_order_relaxed); s += detail::search_block)
+                    if (std::any_of(b + s, b + std::min(last, s + detail::search_block), std::ref(pred)))
+                        hit.store(true, std::memory_order_relaxed);
+            });
+            return hit.load(std::memory_order_relaxed);
+        } else return (*this)(std::forward<R>(range), std::forward<Pred>(pred));
+    }
+} any_of{};
+
+// chunks are sorted apart and then merged pairwise, a round of merges at a time
+constexpr struct sort_t {
+    template <class R, class Comp = std::less<>, class = is_range_t<R>>
+    constexpr void operator()(R&& range, Comp&& comp = {}) const {
+        auto v = std::forward<R>(range) | view::common;
+        std::sort(begin(v), end(v), std::forward<Comp>(comp));
+    }
+    template <class E, class R, class Comp = std::less<>, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    void operator()(E&& policy, R&& range, Comp&& comp = {}) const {
+        if constexpr (detail::parallel_v<E, R>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::common;
+            auto b = begin(v);
+            detail::chunks c{p, static_cast<size_t>(end(v) - b)};
+            c.run(p, [&](size_t, size_t first, size_t last) {
+                std::sort(b + first, b + last, std::ref(comp));
+            });
+            for (size_t width = 1; width < c.k; width *= 2) {
+                p.executor().run((c.k + 2 * width - 1) / (2 * width), [&](size_t i) {
+                    auto lo = i * 2 * width, mid = lo + width;
+                    if (mid >= c.k) return;
+                    auto hi = std::min(mid + width, c.k);
+                    std::inplace_merge(b + c.bound(lo), b + c.bound(mid), b + c.bound(hi), std::ref(comp));
+                });
+            }
+        } else (*this)(std::forward<R>(range), std::forward<Comp>(comp));
+    }
+} sort{};
+
+// moves the elements accepted by pred to the front, returns the end of them, neither half keeps its order
+constexpr struct partition_t {
+    template <class R, class Pred, class = is_range_t<R>>
+    constexpr auto operator()(R&& range, Pred&& pred) const {
+        auto v = std::forward<R>(range) | view::common;
+        return std::partition(begin(v), end(v), std::forward<Pred>(pred));
+    }
+    template <class E, class R, class Pred, class = std::enable_if_t<execution::is_execution_policy_v<E>>>
+    auto operator()(E&& policy, R&& range, Pred&& pred) const {
+        if constexpr (detail::parallel_v<E, R>) {
+            auto p = execution::policy_of(policy);
+            auto v = std::forward<R>(range) | view::common;
+            auto b = begin(v);
+            detail::chunks c{p, static_cast<size_t>(end(v) - b)};
+            std::vector<size_t> mids(c.k);
+            c.run(p, [&](size_t i, size_t first, size_t last) {
+                mids[i] = static_cast<size_t>(std::partition(b + first, b + last, std::ref(pred)) - b);
+            });
+            // rotate the accepted part of each chunk next to those before it
+            auto m = mids[0];
+            for (size_t i = 1; i < c.k; ++i) {
+                auto first = c.bound(i);
+                std::rotate(b + m, b + first, b + mids[i]);
+                m += mids[i] - first;
+            }
+            return b + m;
+        } else return (*this)(std::forward<R>(range), std::forward<Pred>(pred));
+    }
+} partition{};
+
 }
@@ -0,0 +1,75 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <type_traits>
+
+#include "vigna/core/thread_pool.hpp"
+
+// <execution> drags in the parallel backend of the standard library, which has to be linked
+#ifdef VIGNA_STD_EXECUTION
+#   include <execution>
+#endif
+
+namespace vigna::execution {
+
+struct sequenced_policy {};
+
+// grain is the fewest elements worth handing to a thread, 0 picks a default
+struct parallel_policy {
+    thread_pool* pool = nullptr;
+    size_t grain = 0;
+
+    [[nodiscard]] thread_pool& executor() const { return pool ? *pool : thread_pool::shared(); }
+};
+
+constexpr sequenced_policy seq{};
+constexpr parallel_policy par{};
+
+// the parallel policy running on a given pool
+constexpr parallel_policy on(thread_pool& pool, size_t grain = 0) { return {&pool, grain}; }
+
+template <class T>
+struct policy_traits {
+    static constexpr bool value = false;
+};
+
+template <>
+struct policy_traits<sequenced_policy> {
+    static constexpr bool value = true;
+    static constexpr sequenced_policy get(sequenced_policy) { return {}; }
+};
+
+template <>
+struct policy_traits<parallel_policy> {
+    static constexpr bool value = true;
+    static constexpr parallel_policy get(parallel_policy p) { return p; }
+};
+
+#ifdef VIGNA_STD_EXECUTION
+template <>
+struct policy_traits<std::execution::sequenced_policy> : policy_traits<sequenced_policy> {
+    static constexpr sequenced_policy get(const std::execution::sequenced_policy&) { return {}; }
+};
+
+template <>
+struct policy_traits<std::execution::parallel_policy> : policy_traits<parallel_policy> {
+    static constexpr parallel_policy get(const std::execution::parallel_policy&) { return {}; }
+};
+
+template <>
+struct policy_traits<std::execution::parallel_unsequenced_policy> : policy_traits<parallel_policy> {
+    static constexpr parallel_policy get(const std::execution::parallel_unsequenced_policy&) { return {}; }
+};
+#endif
+
+template <class T>
+constexpr bool is_execution_policy_v = policy_traits<std::decay_t<T>>::value;
+
+// the vigna policy standing for an accepted one
+template <class T>
+constexpr auto policy_of(const T& policy) { return policy_traits<std::decay_t<T>>::get(policy); }
+
+}
@@ -7,4 +7,5 @@
 #include "range.hpp"
 #include "iterator.hpp"
 #include "view.hpp"
+#include "execution.hpp"
 #include "algo.hpp"
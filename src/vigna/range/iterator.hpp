@@ -6,7 +6,7 @@
 
 #include <limits>
 #include <tuple>
-#include <variant>
+#include <cassert>
 
 #include "range.hpp"
 
@@ -21,6 +21,9 @@ struct default_filter {
 
 }
 
+template <class It, class Sentinel>
+struct subrange;
+
 template <class T, class = std::enable_if_t<std::is_integral_v<T>>>
 struct iota_iterator {
     using value_type = T;
@@ -81,6 +84,9 @@ struct input_iterator_pointer {
     value_type inner;
 };
 
+// random access members below are only instantiated when used, so they are
+// declared unconditionally and the category tells which of them are valid
+
 template <class It, class...Args>
 struct packed_iterator {
     using inner_type = decltype(std::make_tuple(std::declval<It>(), std::declval<Args>()...));
@@ -88,7 +94,7 @@ struct packed_iterator {
     using pointer = input_iterator_pointer<value_type>;
     using reference = value_type;
     using difference_type = std::ptrdiff_t;
-    using iterator_category = std::input_iterator_tag;
+    using iterator_category = adapted_category_t<std::random_access_iterator_tag, It, Args...>;
 
     constexpr packed_iterator() = default;
     constexpr explicit packed_iterator(const It& it, Args const& ... args)
@@ -100,16 +106,27 @@ struct packed_iterator {
     constexpr void _increase(std::index_sequence<I...>) {(++std::get<I>(it), ...);}
     template <size_t...I>
     constexpr void _decrease(std::index_sequence<I...>) {(--std::get<I>(it), ...);}
+    template <size_t...I>
+    constexpr void _advance(difference_type n, std::index_sequence<I...>) {((std::get<I>(it) += n), ...);}
     auto operator*() const {return _get(std::make_index_sequence<sizeof...(Args) + 1>{});}
     pointer operator->() const {return **this;}
+    auto operator[](difference_type n) const {return *(*this + n);}
     packed_iterator& operator++() {return _increase(std::make_index_sequence<sizeof...(Args) + 1>{}), *this;}
     packed_iterator operator++(int) {auto cp = *this; return _increase(std::make_index_sequence<sizeof...(Args) + 1>{}), cp;}
     packed_iterator& operator--() {return _decrease(std::make_index_sequence<sizeof...(Args) + 1>{}), *this;}
     packed_iterator operator--(int) {auto cp = *this; return _decrease(std::make_index_sequence<sizeof...(Args) + 1>{}), cp;}
+    packed_iterator& operator+=(difference_type n) {return _advance(n, std::make_index_sequence<sizeof...(Args) + 1>{}), *this;}
+    packed_iterator& operator-=(difference_type n) {return *this += -n;}
+    packed_iterator operator+(difference_type n) const {auto cp = *this; return cp += n;}
+    packed_iterator operator-(difference_type n) const {auto cp = *this; return cp -= n;}
+    template <class...Args_>
+    difference_type operator-(const packed_iterator<It, Args_...>& other) const {return std::get<0>(it) - std::get<0>(other.it);}
     template <class...Args_>
     bool operator==(const packed_iterator<It, Args_...>& other) const {return std::get<0>(it) == std::get<0>(other.it);}
     template <class...Args_>
     bool operator!=(const packed_iterator<It, Args_...>& other) const {return std::get<0>(it) != std::get<0>(other.it);}
+    template <class...Args_>
+    bool operator<(const packed_iterator<It, Args_...>& other) const {return std::get<0>(it) < std::get<0>(other.it);}
 
     inner_type it;
 };
@@ -120,7 +137,7 @@ struct filter_iterator {
     using pointer = value_type*;
     using reference = value_type&;
     using difference_type = std::ptrdiff_t;
-    using iterator_category = std::input_iterator_tag;
+    using iterator_category = adapted_category_t<std::forward_iterator_tag, It>;
 
     constexpr filter_iterator() = default;
     constexpr filter_iterator(const It& it_, const It& end_, const Fn& fn_)
@@ -136,7 +153,7 @@ struct filter_iterator {
         return *this;
     }
     filter_iterator operator++(int) {
-        auto cp = *this; return ++it, cp;
+        auto cp = *this; return ++*this, cp;
     }
     template <class It_, class Fn_>
     bool operator==(const filter_iterator<It_, Fn_>& other) const {return it == other.it;}
@@ -157,7 +174,7 @@ struct transform_iterator {
             std::is_same_v<inner_it_value_t, std::decay_t<inner_it_value_t>>,
         std::decay_t<value_type>, value_type>;
     using difference_type = std::ptrdiff_t;
-    using iterator_category = std::input_iterator_tag;
+    using iterator_category = adapted_category_t<std::random_access_iterator_tag, It>;
 
     constexpr transform_iterator() = default;
     constexpr explicit transform_iterator(const It& it, const Fn& fn)
@@ -167,49 +184,235 @@ struct transform_iterator {
 
     reference operator*() const {return fn(*it);}
     pointer operator->() const {return fn(*it);}
+    reference operator[](difference_type n) const {return fn(it[n]);}
     transform_iterator& operator++() {return ++it, *this;}
     transform_iterator operator++(int) {auto cp = *this; return ++it, cp;}
     transform_iterator& operator--() {return --it, *this;}
     transform_iterator operator--(int) {auto cp = *this; return --it, cp;}
+    transform_iterator& operator+=(difference_type n) {return it += n, *this;}
+    transform_iterator& operator-=(difference_type n) {return it -= n, *this;}
+    transform_iterator operator+(difference_type n) const {return transform_iterator(it + n, fn);}
+    transform_iterator operator-(difference_type n) const {return transform_iterator(it - n, fn);}
+    // end iterators of a transform view carry no function, so every comparison is across types
+    template <class It_, class Fn_>
+    difference_type operator-(const transform_iterator<It_, Fn_>& other) const {return it - other.it;}
     template <class It_, class Fn_>
     bool operator==(const transform_iterator<It_, Fn_>& other) const {return it == other.it;}
     template <class It_, class Fn_>
     bool operator!=(const transform_iterator<It_, Fn_>& other) const {return it != other.it;}
+    template <class It_, class Fn_>
+    bool operator<(const transform_iterator<It_, Fn_>& other) const {return it < other.it;}
 
     It it;
     Fn fn;
 };
 
+// one type for both ends of a range whose sentinel differs from its iterator,
+// both are kept so that no dereference has to find out which one is held
 template <class It, class Sen, class = std::enable_if_t<is_compatible_iterator_v<It, Sen>>>
 struct common_iterator {
-    using inner_type = std::variant<It, Sen>;
     using result_type = decltype(*std::declval<It>());
     using value_type = std::remove_reference_t<result_type>;
     using pointer = value_type*;
     using reference = result_type;
     using difference_type = std::ptrdiff_t;
-    using iterator_category = std::input_iterator_tag;
-
-    common_iterator() = default;
+    using iterator_category = adapted_category_t<std::forward_iterator_tag, It>;
 
-    template<class T, class =
-        std::enable_if_t<std::is_same_v<std::decay_t<T>, It> || std::is_same_v<std::decay_t<T>, Sen>>>
-    explicit common_iterator(T&& it) : inner(std::forward<T>(it)) {}
+    common_iterator(const It& it, const Sen& sen, bool at_end) : it(it), sen(sen), at_end(at_end) {}
 
-    decltype(auto) operator*() const {
-        return std::visit([](auto&& it) -> result_type {
-            if constexpr (std::is_same_v<result_type, decltype(*it)>)
-                return *it;
-            else assert(false && "Invalid dereferencing");
-        }, inner);
+    reference operator*() const { return assert(!at_end && "Invalid dereferencing"), *it; }
+    pointer operator->() const { return std::addressof(**this); }
+    common_iterator& operator++() { return assert(!at_end), ++it, *this; }
+    common_iterator operator++(int) { auto cp = *this; return ++*this, cp; }
+    bool operator==(const common_iterator& o) const {
+        if (at_end == o.at_end) return at_end || it == o.it;
+        return at_end ? !(o.it != sen) : !(it != o.sen);
     }
-    pointer operator->() const { return std::addressof(deref_(inner)); }
-    common_iterator& operator++() { return std::visit([](auto&&i){++i;}, inner), *this; }
-    common_iterator operator++(int) { auto cp = *this; return inc_(inner), cp; }
-    bool operator==(const common_iterator& o) const { return std::visit([](auto&& a, auto&& b) { return a == b; }, inner, o.inner); }
     bool operator!=(const common_iterator& o) const { return !(*this == o); }
 
-    inner_type inner;
+    It it;
+    Sen sen;
+    bool at_end;
+};
+
+// stops after count steps or at the end of the underlying range, whichever comes first
+template <class It, class Sen = It>
+struct counted_iterator {
+    using value_type = std::remove_reference_t<decltype(*std::declval<It>())>;
+    using pointer = value_type*;
+    using reference = decltype(*std::declval<It>());
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = adapted_category_t<std::forward_iterator_tag, It>;
+
+    counted_iterator(const It& it, const Sen& end, size_t count) : it(it), end(end), count(count) {}
+
+    [[nodiscard]] bool done() const { return count == 0 || !(it != end); }
+
+    reference operator*() const { return assert(!done()), *it; }
+    pointer operator->() const { return std::addressof(**this); }
+    counted_iterator& operator++() { return assert(!done()), ++it, --count, *this; }
+    counted_iterator operator++(int) { auto cp = *this; return ++*this, cp; }
+    bool operator==(const counted_iterator& o) const { return done() ? o.done() : !o.done() && count == o.count; }
+    bool operator!=(const counted_iterator& o) const { return !(*this == o); }
+
+    It it;
+    Sen end;
+    size_t count;
+};
+
+// walks several ranges in lock step and ends with the shortest
+template <class...Its>
+struct zip_iterator {
+    using value_type = std::tuple<decltype(*std::declval<Its>())...>;
+    using pointer = input_iterator_pointer<value_type>;
+    using reference = value_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = adapted_category_t<std::random_access_iterator_tag, Its...>;
+
+    zip_iterator() = default;
+    constexpr explicit zip_iterator(const Its&...its) : its(its...) {}
+
+    reference operator*() const { return std::apply([](auto&&...i) { return reference{*i...}; }, its); }
+    pointer operator->() const { return pointer{**this}; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+    zip_iterator& operator++() { return std::apply([](auto&...i) { (++i, ...); }, its), *this; }
+    zip_iterator operator++(int) { auto cp = *this; return ++*this, cp; }
+    zip_iterator& operator--() { return std::apply([](auto&...i) { (--i, ...); }, its), *this; }
+    zip_iterator operator--(int) { auto cp = *this; return --*this, cp; }
+    zip_iterator& operator+=(difference_type n) { return std::apply([n](auto&...i) { ((i += n), ...); }, its), *this; }
+    zip_iterator& operator-=(difference_type n) { return *this += -n; }
+    zip_iterator operator+(difference_type n) const { auto cp = *this; return cp += n; }
+    zip_iterator operator-(difference_type n) const { auto cp = *this; return cp -= n; }
+
+    // the distance of the component closest to its counterpart
+    template <class...Os>
+    difference_type operator-(const zip_iterator<Os...>& o) const {
+        return diff_(o, std::index_sequence_for<Its...>{});
+    }
+    template <class...Os>
+    bool operator==(const zip_iterator<Os...>& o) const { return any_equal_(o, std::index_sequence_for<Its...>{}); }
+    template <class...Os>
+    bool operator!=(const zip_iterator<Os...>& o) const { return !(*this == o); }
+    template <class...Os>
+    bool operator<(const zip_iterator<Os...>& o) const { return std::get<0>(its) < std::get<0>(o.its); }
+
+    std::tuple<Its...> its;
+
+private:
+    template <class...Os, size_t...I>
+    bool any_equal_(const zip_iterator<Os...>& o, std::index_sequence<I...>) const {
+        return (... || !(std::get<I>(its) != std::get<I>(o.its)));
+    }
+    template <class...Os, size_t...I>
+    difference_type diff_(const zip_iterator<Os...>& o, std::index_sequence<I...>) const {
+        difference_type d[]{static_cast<difference_type>(std::get<I>(its) - std::get<I>(o.its))...};
+        return *std::min_element(std::begin(d), std::end(d), [](auto a, auto b) { return (a < 0 ? -a : a) < (b < 0 ? -b : b); });
+    }
+};
+
+// every step-th element, missing keeps the overshoot of the last step so that
+// random access arithmetic from the end stays exact
+template <class It, class Sen = It>
+struct stride_iterator {
+    using value_type = std::remove_reference_t<decltype(*std::declval<It>())>;
+    using pointer = value_type*;
+    using reference = decltype(*std::declval<It>());
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::conditional_t<is_random_access_v<It>,
+        std::random_access_iterator_tag, adapted_category_t<std::forward_iterator_tag, It>>;
+
+    stride_iterator(const It& it, const Sen& end, difference_type step, difference_type missing = 0)
+        : it(it), end(end), step(step), missing(missing) { assert(step > 0); }
+
+    reference operator*() const { return *it; }
+    pointer operator->() const { return std::addressof(*it); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    stride_iterator& operator++() {
+        if constexpr (is_random_access_v<It>) return *this += 1;
+        else {
+            for (difference_type i = 0; i < step && it != end; ++i) ++it;
+            return *this;
+        }
+    }
+    stride_iterator operator++(int) { auto cp = *this; return ++*this, cp; }
+    stride_iterator& operator--() { return *this -= 1; }
+    stride_iterator operator--(int) { auto cp = *this; return --*this, cp; }
+
+    stride_iterator& operator+=(difference_type n) {
+        if (n > 0) {
+            auto want = n * step;
+            auto moved = std::min<difference_type>(want, end - it);
+            it += moved, missing = want - moved;
+        } else if (n < 0) {
+            it += n * step + missing, missing = 0;
+        }
+        return *this;
+    }
+    stride_iterator& operator-=(difference_type n) { return *this += -n; }
+    stride_iterator operator+(difference_type n) const { auto cp = *this; return cp += n; }
+    stride_iterator operator-(difference_type n) const { auto cp = *this; return cp -= n; }
+
+    template <class It_, class Sen_>
+    difference_type operator-(const stride_iterator<It_, Sen_>& o) const {
+        auto n = static_cast<difference_type>(it - o.it) + missing - o.missing;
+        return n >= 0 ? (n + step - 1) / step : -((-n + step - 1) / step);
+    }
+    template <class It_, class Sen_>
+    bool operator==(const stride_iterator<It_, Sen_>& o) const { return !(it != o.it); }
+    template <class It_, class Sen_>
+    bool operator!=(const stride_iterator<It_, Sen_>& o) const { return it != o.it; }
+    template <class It_, class Sen_>
+    bool operator<(const stride_iterator<It_, Sen_>& o) const { return it < o.it; }
+
+    It it;
+    Sen end;
+    difference_type step;
+    difference_type missing;
+};
+
+// consecutive subranges of n elements, the last one may be shorter
+template <class It, class Sen = It>
+struct chunk_iterator : private stride_iterator<It, Sen> {
+    using base_type = stride_iterator<It, Sen>;
+    using value_type = subrange<It, It>;
+    using pointer = input_iterator_pointer<value_type>;
+    using reference = value_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = typename base_type::iterator_category;
+
+    chunk_iterator(const It& it, const Sen& end, difference_type n, difference_type missing = 0)
+        : base_type(it, end, n, missing) {}
+
+    reference operator*() const {
+        auto last = this->it;
+        if constexpr (is_random_access_v<It>)
+            last += std::min<difference_type>(this->step, this->end - this->it);
+        else for (difference_type i = 0; i < this->step && last != this->end; ++i) ++last;
+        return value_type{this->it, last};
+    }
+    pointer operator->() const { return pointer{**this}; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    chunk_iterator& operator++() { return base_type::operator++(), *this; }
+    chunk_iterator operator++(int) { auto cp = *this; return ++*this, cp; }
+    chunk_iterator& operator--() { return base_type::operator--(), *this; }
+    chunk_iterator operator--(int) { auto cp = *this; return --*this, cp; }
+    chunk_iterator& operator+=(difference_type n) { return base_type::operator+=(n), *this; }
+    chunk_iterator& operator-=(difference_type n) { return base_type::operator-=(n), *this; }
+    chunk_iterator operator+(difference_type n) const { auto cp = *this; return cp += n; }
+    chunk_iterator operator-(difference_type n) const { auto cp = *this; return cp -= n; }
+
+    template <class It_, class Sen_>
+    difference_type operator-(const chunk_iterator<It_, Sen_>& o) const { return base() - o.base(); }
+    template <class It_, class Sen_>
+    bool operator==(const chunk_iterator<It_, Sen_>& o) const { return base() == o.base(); }
+    template <class It_, class Sen_>
+    bool operator!=(const chunk_iterator<It_, Sen_>& o) const { return base() != o.base(); }
+    template <class It_, class Sen_>
+    bool operator<(const chunk_iterator<It_, Sen_>& o) const { return base() < o.base(); }
+
+    [[nodiscard]] const base_type& base() const { return *this; }
 };
 
 }
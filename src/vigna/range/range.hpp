@@ -4,7 +4,11 @@
 
 #pragma once
 
+#include <tuple>
 #include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
 
 namespace vigna::range {
 
@@ -34,6 +38,46 @@ constexpr bool is_compatible_iterator_v<T, U, std::enable_if_t<
     is_iterable_v<T> && is_iterable_v<U>,
     std::void_t<decltype(std::declval<T>() != std::declval<U>())>>> = true;
 
+template <class It, class = void>
+struct iterator_category_of { using type = std::input_iterator_tag; };
+template <class It>
+struct iterator_category_of<It, std::void_t<typename std::iterator_traits<It>::iterator_category>> {
+    using type = typename std::iterator_traits<It>::iterator_category;
+};
+
+template <class It>
+using iterator_category_t = typename iterator_category_of<It>::type;
+
+namespace detail {
+
+template <class Tag>
+constexpr int category_rank =
+    std::is_base_of_v<std::random_access_iterator_tag, Tag> ? 3 :
+    std::is_base_of_v<std::bidirectional_iterator_tag, Tag> ? 2 :
+    std::is_base_of_v<std::forward_iterator_tag, Tag> ? 1 : 0;
+
+template <int Rank>
+using category_of_rank = std::tuple_element_t<Rank, std::tuple<
+    std::input_iterator_tag, std::forward_iterator_tag, std::bidirectional_iterator_tag, std::random_access_iterator_tag>>;
+
+}
+
+// the strongest category all of the tags satisfy
+template <class...Tags>
+using weakest_category_t = detail::category_of_rank<std::min({detail::category_rank<Tags>...})>;
+
+// the category of an adaptor over Its, capped at Max
+template <class Max, class...Its>
+using adapted_category_t = weakest_category_t<Max, iterator_category_t<Its>...>;
+
+template <class It>
+constexpr bool is_random_access_v = detail::category_rank<iterator_category_t<It>> == 3;
+
+template <class T, class = void>
+constexpr bool is_sized_range_v = false;
+template <class T>
+constexpr bool is_sized_range_v<T, std::void_t<decltype(end(std::declval<T>()) - begin(std::declval<T>()))>> = true;
+
 struct identity {
     template <class U>
     constexpr decltype(auto) operator()(U&& u) const {
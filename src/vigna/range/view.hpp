@@ -18,12 +18,16 @@ struct subrange {
     using reference = value_type&;
 
     constexpr subrange() = default;
-    constexpr subrange(It&& begin, Sentinel&& end)
-    : begin_(std::forward<decltype(begin)>(begin)), end_(std::forward<decltype(end)>(end)) {}
+    constexpr subrange(It begin, Sentinel end)
+    : begin_(std::move(begin)), end_(std::move(end)) {}
 
     [[nodiscard]] constexpr decltype(auto) begin() const { return begin_; }
     [[nodiscard]] constexpr decltype(auto) end() const { return end_; }
 
+    template <class S = Sentinel, class = decltype(std::declval<S>() - std::declval<It>())>
+    [[nodiscard]] constexpr size_t size() const { return static_cast<size_t>(end_ - begin_); }
+    [[nodiscard]] constexpr bool empty() const { return !(begin_ != end_); }
+
 private:
     It begin_;
     Sentinel end_;
@@ -69,28 +73,37 @@ constexpr struct common_t : view_factory {
         using Sen = std::decay_t<decltype(end(rg))>;
         if constexpr (std::is_same_v<It, Sen>) {
             return all(rg);
+        } else if constexpr (is_random_access_v<It> && is_sized_range_v<T>) {
+            auto b = begin(rg);
+            return subrange{b, b + (end(rg) - b)};
         } else {
             using common_it = common_iterator<It, Sen>;
-            return subrange{common_it{begin(rg)}, common_it{end(rg)}};
+            return subrange{common_it{begin(rg), end(rg), false}, common_it{begin(rg), end(rg), true}};
         }
     }
 } common{};
 
 constexpr struct take_t {
-    template <class T, class = void>
-    struct impl_func;
     template <class T>
-    struct impl_func<T, std::void_t<std::enable_if_t<is_range_v<T>, decltype(begin(std::declval<T>()) + size_t{})>>> {
-        constexpr auto operator()(T&& rg, size_t n) const { return subrange{begin(rg), begin(rg) + n}; }
-    };
+    static constexpr auto impl(T&& rg, size_t n) {
+        using It = std::decay_t<decltype(begin(rg))>;
+        if constexpr (is_random_access_v<It> && is_sized_range_v<T>) {
+            auto b = begin(rg);
+            return subrange{b, b + static_cast<std::ptrdiff_t>(std::min(n, static_cast<size_t>(end(rg) - b)))};
+        } else {
+            using Sen = std::decay_t<decltype(end(rg))>;
+            using counted_it = counted_iterator<It, Sen>;
+            return subrange{counted_it{begin(rg), end(rg), n}, counted_it{begin(rg), end(rg), 0}};
+        }
+    }
     struct impl_obj : view_factory {
         template <class T, class = is_range_t<T>>
-        constexpr auto operator()(T&& rg) const { return impl_func<T>{}(std::forward<T>(rg), n); }
+        constexpr auto operator()(T&& rg) const { return impl(std::forward<T>(rg), n); }
         constexpr explicit impl_obj(size_t size) : n(size) {}
         size_t n;
     };
     template <class T, class = is_range_t<T>>
-    constexpr auto operator()(T&& rg, size_t n) const { return impl_func<T>{}(std::forward<T>(rg), n); }
+    constexpr auto operator()(T&& rg, size_t n) const { return impl(std::forward<T>(rg), n); }
     constexpr auto operator()(size_t n) const { return impl_obj{n}; }
 } take{};
 
@@ -151,15 +164,75 @@ constexpr struct transform_t {
     constexpr auto operator()(Fn&& fn) const { return impl_obj<Fn>{std::forward<Fn>(fn)}; }
 } transform{};
 
-} // namespace _algo
+constexpr struct zip_t {
+    template <class...Ranges, class = std::enable_if_t<sizeof...(Ranges) != 0 && (is_range_v<Ranges> && ...)>>
+    constexpr auto operator()(Ranges&&...rgs) const {
+        return subrange{zip_iterator{begin(rgs)...}, zip_iterator{end(rgs)...}};
+    }
+} zip{};
 
-template <class T, class>
-struct take_t::impl_func {
-    constexpr auto operator()(T&& rg, size_t n) const {
-        auto t = subrange{iota_iterator{size_t{0}}, iota_iterator{n}};
-        return pack(t, rg) | transform([](auto&& i) {return std::get<1>(i);});
+// (index, element) pairs, the index is bounded by the size when the range knows it
+constexpr struct enumerate_t : view_factory {
+    constexpr auto& operator()() const {return *this;}
+    template <class T, class = is_range_t<T>>
+    constexpr auto operator()(T&& rg) const {
+        if constexpr (is_sized_range_v<T>) {
+            auto n = static_cast<size_t>(end(rg) - begin(rg));
+            return zip(subrange{iota_iterator<size_t>{0}, iota_iterator<size_t>{n}}, rg);
+        } else return zip(iota(size_t{0}), rg);
     }
-};
+} enumerate{};
+
+constexpr struct stride_t {
+    template <class T>
+    static constexpr auto impl(T&& rg, size_t n) {
+        using It = std::decay_t<decltype(begin(rg))>;
+        using Sen = std::decay_t<decltype(end(rg))>;
+        auto step = static_cast<std::ptrdiff_t>(n);
+        if constexpr (is_random_access_v<It> && std::is_same_v<It, Sen>) {
+            auto size = end(rg) - begin(rg);
+            return subrange{stride_iterator<It, Sen>{begin(rg), end(rg), step},
+                            stride_iterator<It, Sen>{end(rg), end(rg), step, (step - size % step) % step}};
+        } else return subrange{stride_iterator<It, Sen>{begin(rg), end(rg), step},
+                               stride_iterator<Sen, Sen>{end(rg), end(rg), step}};
+    }
+    struct impl_obj : view_factory {
+        template <class T, class = is_range_t<T>>
+        constexpr auto operator()(T&& rg) const { return impl(std::forward<T>(rg), n); }
+        constexpr explicit impl_obj(size_t step) : n(step) {}
+        size_t n;
+    };
+    template <class T, class = is_range_t<T>>
+    constexpr auto operator()(T&& rg, size_t n) const { return impl(std::forward<T>(rg), n); }
+    constexpr auto operator()(size_t n) const { return impl_obj{n}; }
+} stride{};
+
+constexpr struct chunk_t {
+    template <class T>
+    static constexpr auto impl(T&& rg, size_t n) {
+        using It = std::decay_t<decltype(begin(rg))>;
+        static_assert(std::is_same_v<It, std::decay_t<decltype(end(rg))>>, "Chunks need a common range");
+        auto step = static_cast<std::ptrdiff_t>(n);
+        std::ptrdiff_t missing = 0;
+        if constexpr (is_random_access_v<It>) {
+            auto size = end(rg) - begin(rg);
+            missing = (step - size % step) % step;
+        }
+        return subrange{chunk_iterator<It>{begin(rg), end(rg), step},
+                        chunk_iterator<It>{end(rg), end(rg), step, missing}};
+    }
+    struct impl_obj : view_factory {
+        template <class T, class = is_range_t<T>>
+        constexpr auto operator()(T&& rg) const { return impl(std::forward<T>(rg), n); }
+        constexpr explicit impl_obj(size_t size) : n(size) {}
+        size_t n;
+    };
+    template <class T, class = is_range_t<T>>
+    constexpr auto operator()(T&& rg, size_t n) const { return impl(std::forward<T>(rg), n); }
+    constexpr auto operator()(size_t n) const { return impl_obj{n}; }
+} chunk{};
+
+} // namespace _algo
 
 } // namespace view
 
@@ -49,6 +49,11 @@ constexpr HashValue type_hash() {
         hash_value *= prime2;
     }
 
+    // fold the high half in, names differing in their last letter only differ in the top bits before this
+    hash_value ^= hash_value >> 33;
+    hash_value *= 0xff51afd7ed558ccdu;
+    hash_value ^= hash_value >> 33;
+
     return static_cast<HashValue>(hash_value & ~HashValue(0));
 }
 
@@ -4,9 +4,14 @@
 
 #pragma once
 
+#include <new>
 #include <memory>
+#include <cstdint>
+#include <cstring>
+#include <utility>
 #include <functional>
 
+#include "vigna/config.h"
 #include "vigna/reflect/function_traits.hpp"
 
 namespace vigna {
@@ -15,91 +20,228 @@ enum class signal_r {
     keep, erase
 };
 
+namespace detail {
+
+struct connection_slot {
+    uint32_t index; // into the calls when in use, next free slot otherwise
+    uint32_t version;
+};
+
+// the part of the block of a signal that connections see, without virtual calls: the slots, which the
+// signal keeps pointing at, and a count of the connections referring to it, which is not atomic, as
+// connections are no more thread safe than their signal. the signal owns it and lets go when it dies,
+// from then on it only waits for the last connection, with every slot released
+class connection_owner {
+public:
+    using release_type = void(connection_owner*, uint32_t);
+    using destroy_type = void(connection_owner*);
+
+    [[nodiscard]] bool connected(uint32_t index, uint32_t version) const {
+        return index < slot_count && slot_data[index].version == version;
+    }
+
+    void release(uint32_t index, uint32_t version) {
+        if (connected(index, version)) release_fn(this, slot_data[index].index);
+    }
+
+    void acquire() { ++refs; }
+
+    void unref() {
+        if (--refs == 0 && orphan) destroy_fn(this);
+    }
+
+    // called by the signal when it lets go, after it has released every slot
+    void abandon() {
+        slot_count = 0;
+        orphan = true;
+        if (refs == 0) destroy_fn(this);
+    }
+
+protected:
+    connection_owner(release_type* release, destroy_type* destroy) : release_fn(release), destroy_fn(destroy) {}
+    ~connection_owner() = default;
+
+    const connection_slot* slot_data{};
+    size_t slot_count{};
+
+private:
+    release_type* release_fn;
+    destroy_type* destroy_fn;
+    uint32_t refs{};
+    bool orphan{};
+};
+
+}
+
+// slot index plus generation, referring to the slots of its signal, which stay put when the signal moves;
+// once the signal is gone it is false and releasing it does nothing
 struct connection {
     connection() = default;
-    explicit connection(const std::shared_ptr<bool>& connected)
-        : connected(connected) {}
+    connection(detail::connection_owner* owner, uint32_t index, uint32_t version)
+        : owner(owner), index(index), version(version) { if (owner) owner->acquire(); }
+
+    connection(const connection& other) : connection(other.owner, other.index, other.version) {}
+    connection(connection&& other) noexcept
+        : owner(std::exchange(other.owner, nullptr)), index(other.index), version(other.version) {}
+    connection& operator=(connection other) noexcept {
+        std::swap(owner, other.owner);
+        index = other.index;
+        version = other.version;
+        return *this;
+    }
+
+    ~connection() { if (owner) owner->unref(); }
 
     [[nodiscard]] explicit operator bool() const {
-        return connected != nullptr ? *connected : false;
+        return owner != nullptr && owner->connected(index, version);
     }
 
     void release() const {
-        if (connected != nullptr)
-            *connected = false;
+        if (owner != nullptr)
+            owner->release(index, version);
     }
 
     [[nodiscard]] bool operator==(const connection& other) const {
-        return connected == other.connected;
+        return owner == other.owner && index == other.index && version == other.version;
     }
 
-private:
-    std::shared_ptr<bool> connected;
+    [[nodiscard]] bool operator!=(const connection& other) const {
+        return !(*this == other);
+    }
 
-    friend class std::hash<connection>;
+private:
+    detail::connection_owner* owner{};
+    uint32_t index{};
+    uint32_t version{};
 
 };
 
 template <class...Args>
 class delegate {
-    using Fn = signal_r(Args...);
+    // callables up to this size are stored in place, larger ones go to the heap
+    static constexpr size_t storage_size = VIGNA_DELEGATE_STORAGE;
+    static constexpr size_t storage_align = alignof(void*);
+
+    using function_type = signal_r(void*, Args...);
+
+    enum class operation { move, destroy };
+    using manager_type = void(operation, void*, void*);
 
-    template <class, class>
-    friend class signal;
+    template <class T>
+    static constexpr bool fits_inline = sizeof(T) <= storage_size &&
+        storage_align % alignof(T) == 0 && std::is_nothrow_move_constructible_v<T>;
+
+    template <class Fn_, class...Params>
+    static signal_r invoke(Fn_&& fn, Params&&...params) {
+        if constexpr (std::is_same_v<std::invoke_result_t<Fn_, Params...>, signal_r>)
+            return std::invoke(std::forward<Fn_>(fn), std::forward<Params>(params)...);
+        else if constexpr (std::is_invocable_r_v<bool, Fn_, Params...>) // true: keep, false: erase
+            return std::invoke(std::forward<Fn_>(fn), std::forward<Params>(params)...) ? signal_r::keep : signal_r::erase;
+        else return std::invoke(std::forward<Fn_>(fn), std::forward<Params>(params)...), signal_r::keep;
+    }
+
+    template <auto Func>
+    static signal_r free_thunk(void*, Args...args) {
+        return invoke(Func, std::forward<Args>(args)...);
+    }
+
+    template <auto Func, class T>
+    static signal_r member_thunk(void* storage, Args...args) {
+        return invoke(Func, *std::launder(static_cast<T**>(storage)), std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    static signal_r inline_thunk(void* storage, Args...args) {
+        return invoke(*std::launder(static_cast<T*>(storage)), std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    static signal_r heap_thunk(void* storage, Args...args) {
+        return invoke(**std::launder(static_cast<T**>(storage)), std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    static void inline_manager(operation op, void* dst, void* src) {
+        auto* from = std::launder(static_cast<T*>(src));
+        if (op == operation::move) new (dst) T{std::move(*from)};
+        from->~T();
+    }
+
+    template <class T>
+    static void heap_manager(operation op, void* dst, void* src) {
+        auto* from = std::launder(static_cast<T**>(src));
+        if (op == operation::move) new (dst) T*{std::exchange(*from, nullptr)};
+        else delete *from;
+    }
+
+    void steal(delegate& other) {
+        if (other.manager_ != nullptr) other.manager_(operation::move, storage_, other.storage_);
+        else std::memcpy(storage_, other.storage_, storage_size);
+        call_ = std::exchange(other.call_, nullptr);
+        manager_ = std::exchange(other.manager_, nullptr);
+    }
+
+    template <class Fn_>
+    void store(Fn_&& fn) {
+        using type = std::decay_t<Fn_>;
+        reset();
+        if constexpr (fits_inline<type>) {
+            new (storage_) type{std::forward<Fn_>(fn)};
+            call_ = &inline_thunk<type>;
+            if constexpr (!std::is_trivially_copyable_v<type>)
+                manager_ = &inline_manager<type>;
+        } else {
+            new (storage_) type*{new type{std::forward<Fn_>(fn)}};
+            call_ = &heap_thunk<type>;
+            manager_ = &heap_manager<type>;
+        }
+    }
 
 public:
     delegate() = default;
     delegate(const delegate&) = delete;
-    delegate(delegate&&) = default;
+    delegate(delegate&& other) noexcept { steal(other); }
     delegate& operator=(const delegate&) = delete;
-    delegate& operator=(delegate&&) = default;
+    delegate& operator=(delegate&& other) noexcept {
+        if (this != &other) {
+            reset();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~delegate() { reset(); }
 
     template <class Fn_, class = std::enable_if_t<std::is_invocable_v<Fn_, Args...>>>
     explicit delegate(Fn_&& fn) { connect(std::forward<Fn_>(fn)); }
 
-    template<class Alloc, class = std::enable_if_t<!std::is_same_v<bool, delegate>>>
-    explicit delegate(const Alloc& alloc) : connected_(std::allocate_shared<bool>(alloc))
-    { static_assert(std::is_same_v<bool, typename std::allocator_traits<Alloc>::value_type>); }
-
-    template<class Alloc, class Fn_, class = std::enable_if_t<
-        std::is_same_v<bool, typename std::allocator_traits<Alloc>::value_type> &&
-        std::is_invocable_v<Fn_, Args...>>>
-    delegate(const Alloc& alloc, Fn_&& fn) : connected_(std::allocate_shared<bool>(alloc))
-    { connect(std::forward<Fn_>(fn)); }
-
     signal_r operator()(Args&&...args) const {
-        if (!*connected_) return signal_r::erase;
-        return call_(std::forward<Args>(args)...);
+        if (call_ == nullptr) return signal_r::erase;
+        return call_(storage_, std::forward<Args>(args)...);
     }
 
-    [[nodiscard]] connection get_connection() const {
-        return connection{connected_};
+    [[nodiscard]] explicit operator bool() const { return call_ != nullptr; }
+
+    void reset() {
+        if (manager_ != nullptr) manager_(operation::destroy, nullptr, storage_);
+        call_ = nullptr, manager_ = nullptr;
     }
 
     template <class Fn_, class = std::enable_if_t<std::is_invocable_v<Fn_, Args...>>>
-    connection connect(Fn_&& fn) {
-        if constexpr (std::is_invocable_r_v<bool, Fn_, Args...>)
-            call_ = [fn = std::forward<Fn_>(fn)](Args&&...args) mutable {
-                return fn(std::forward<Args>(args)...) ? signal_r::keep : signal_r::erase;
-            }; // true: keep, false: erase
-        else if constexpr (std::is_invocable_r_v<void, Fn_, Args...>)
-            call_ = [fn = std::forward<Fn_>(fn)](Args&&...args) mutable {
-                return fn(std::forward<Args>(args)...), signal_r::keep;
-            };
-        else call_ = std::forward<Fn_>(fn);
-        *connected_ = true;
-        return connection{connected_};
+    void connect(Fn_&& fn) {
+        store(std::forward<Fn_>(fn));
     }
 
     template <auto Func, class = std::enable_if_t<
         std::is_invocable_v<decltype(Func), Args...> ||
         std::is_member_function_pointer_v<decltype(Func)>>>
-    connection connect() {
-        if constexpr (std::is_invocable_v<decltype(Func), Args...>)
-            return connect(Func);
-        else {
+    void connect() {
+        if constexpr (std::is_invocable_v<decltype(Func), Args...>) {
+            reset();
+            call_ = &free_thunk<Func>;
+        } else {
             using clazz = typename reflect::function_traits<decltype(Func)>::clazz;
-            return connect([obj = clazz{}] (Args&&...args) mutable {
+            connect([obj = clazz{}] (Args...args) mutable {
                 return std::invoke(Func, obj, std::forward<Args>(args)...);
             });
         }
@@ -107,40 +249,34 @@ public:
 
     template <auto Func, class T, class = std::enable_if_t<
         std::is_invocable_v<decltype(Func), T&, Args...>>>
-    connection connect(T&& obj) {
-        return connect([obj = std::forward<T>(obj)](Args&&...args) mutable {
+    void connect(T&& obj) {
+        connect([obj = std::forward<T>(obj)](Args...args) mutable {
             return std::invoke(Func, obj, std::forward<Args>(args)...);
         });
     }
 
     template <auto Func, class T, class = std::enable_if_t<
         std::is_invocable_v<decltype(Func), T*, Args...>>>
-    connection connect(T* obj) {
-        return connect([=](Args&&...args) mutable {
-            return std::invoke(Func, obj, std::forward<Args>(args)...);
-        });
+    void connect(T* obj) {
+        reset();
+        new (storage_) T*{obj};
+        call_ = &member_thunk<Func, T>;
     }
 
     template <auto Func, class T, class = std::enable_if_t<
         std::is_invocable_v<decltype(Func), T&, Args...>>>
-    connection connect_shared(const std::shared_ptr<T>& p) {
-        return connect([=](Args&&...args) mutable {
+    void connect_shared(const std::shared_ptr<T>& p) {
+        connect([p](Args...args) {
             return std::invoke(Func, *p, std::forward<Args>(args)...);
         });
     }
 
 private:
-    std::function<Fn> call_;
-    std::shared_ptr<bool> connected_{ new bool{} };
+    alignas(storage_align) mutable unsigned char storage_[storage_size]{};
+    function_type* call_{};
+    manager_type* manager_{};
 
 };
 
 }
 
-template <>
-struct std::hash<vigna::connection> : std::hash<std::shared_ptr<bool>> {
-    using std::hash<std::shared_ptr<bool>>::operator();
-    size_t operator()(const vigna::connection& c) const noexcept {
-        return (*this)(c.connected);
-    }
-};
@@ -0,0 +1,169 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cassert>
+
+#include "sink.hpp"
+#include "vigna/core/dense_map.hpp"
+#include "vigna/reflect/type_hash.hpp"
+
+namespace vigna {
+
+namespace detail {
+
+struct basic_dispatcher_handler {
+    virtual ~basic_dispatcher_handler() = default;
+    virtual void publish() = 0;
+    virtual void clear() = 0;
+    [[nodiscard]] virtual size_t size() const = 0;
+};
+
+// queue of a single event type, enqueue writes the front buffer while publish drains the back one
+template <class Event, class Alloc>
+class dispatcher_handler final : public basic_dispatcher_handler {
+    using alloc_traits = std::allocator_traits<Alloc>;
+    using container_type = std::vector<Event, typename alloc_traits::template rebind_alloc<Event>>;
+
+public:
+    using signal_type = signal_alloc<typename alloc_traits::template rebind_alloc<delegate<Event&>>, Event&>;
+    using sink_type = vigna::sink<signal_type>;
+
+    explicit dispatcher_handler(const Alloc& alloc)
+        : signal_(typename alloc_traits::template rebind_alloc<delegate<Event&>>{alloc}),
+          front_(typename container_type::allocator_type{alloc}),
+          back_(typename container_type::allocator_type{alloc}) {}
+
+    void publish() override {
+        assert(back_.empty() && "Recursive update of the same event type");
+        back_.swap(front_); // events raised by listeners land in the next update
+        for (auto&& e : back_) signal_.emit(e);
+        back_.clear(); // keeps the capacity of both buffers
+    }
+
+    void clear() override { front_.clear(); }
+
+    [[nodiscard]] size_t size() const override { return front_.size(); }
+
+    template <class...Args>
+    void enqueue(Args&&...args) {
+        if constexpr (std::is_aggregate_v<Event>)
+            front_.push_back(Event{std::forward<Args>(args)...});
+        else front_.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void trigger(Event& e) { signal_.emit(e); }
+
+    [[nodiscard]] sink_type sink() { return sink_type{signal_}; }
+
+private:
+    signal_type signal_;
+    container_type front_;
+    container_type back_;
+
+};
+
+}
+
+// deferred events in per type contiguous queues, delivered in batch on update
+template <class Alloc = std::allocator<void>>
+class basic_dispatcher {
+    using alloc_traits = std::allocator_traits<Alloc>;
+
+    using hash_value = uint32_t;
+    using base_handler = detail::basic_dispatcher_handler;
+    using pool_container_type = dense_map<hash_value, std::shared_ptr<base_handler>,
+        std::hash<hash_value>, std::equal_to<hash_value>,
+        typename alloc_traits::template rebind_alloc<std::pair<const hash_value, std::shared_ptr<base_handler>>>>;
+
+    template <class Event>
+    using handler_type = detail::dispatcher_handler<Event, Alloc>;
+
+    template <class Event>
+    handler_type<Event>& assure() {
+        static_assert(std::is_same_v<Event, std::decay_t<Event>>, "Non-decayed types not allowed");
+        auto id = reflect::type_hash<Event, hash_value>();
+        if (auto it = pools_.find(id); it != pools_.end())
+            return static_cast<handler_type<Event>&>(*it->second);
+        auto handler = std::allocate_shared<handler_type<Event>>(
+            typename alloc_traits::template rebind_alloc<handler_type<Event>>{get_allocator()}, get_allocator());
+        auto& ret = *handler;
+        pools_.emplace(id, std::move(handler));
+        return ret;
+    }
+
+    template <class Event>
+    [[nodiscard]] const handler_type<Event>* assure() const {
+        auto it = pools_.find(reflect::type_hash<Event, hash_value>());
+        return it != pools_.end() ? static_cast<const handler_type<Event>*>(it->second.get()) : nullptr;
+    }
+
+public:
+    using allocator_type = Alloc;
+
+    basic_dispatcher() : basic_dispatcher(allocator_type{}) {}
+    explicit basic_dispatcher(const allocator_type& alloc)
+        : pools_{typename pool_container_type::allocator_type{alloc}}, alloc_(alloc) {}
+
+    [[nodiscard]] allocator_type get_allocator() const { return alloc_; }
+
+    template <class Event>
+    [[nodiscard]] auto sink() { return assure<Event>().sink(); }
+
+    template <class Event, class...Args>
+    void enqueue(Args&&...args) {
+        assure<Event>().enqueue(std::forward<Args>(args)...);
+    }
+
+    template <class Event>
+    void enqueue(Event&& e) {
+        assure<std::decay_t<Event>>().enqueue(std::forward<Event>(e));
+    }
+
+    // delivers immediately, bypassing the queue
+    template <class Event>
+    void trigger(Event e = {}) {
+        assure<Event>().trigger(e);
+    }
+
+    template <class Event>
+    void update() { assure<Event>().publish(); }
+
+    void update() {
+        // indexed walk, listeners may enqueue events of a type not seen before
+        for (size_t i = 0; i < pools_.size(); ++i)
+            (pools_.begin() + i)->second->publish();
+    }
+
+    template <class Event>
+    void clear() { assure<Event>().clear(); }
+
+    void clear() {
+        for (auto&& [id, pool] : pools_) pool->clear();
+    }
+
+    template <class Event>
+    [[nodiscard]] size_t size() const {
+        auto pool = assure<Event>();
+        return pool ? pool->size() : 0;
+    }
+
+    [[nodiscard]] size_t size() const {
+        size_t n = 0;
+        for (auto&& [id, pool] : pools_) n += pool->size();
+        return n;
+    }
+
+private:
+    pool_container_type pools_;
+    allocator_type alloc_;
+
+};
+
+using dispatcher = basic_dispatcher<>;
+
+}
@@ -7,3 +7,5 @@
 #include "delegate.hpp"
 #include "signal.hpp"
 #include "sink.hpp"
+#include "dispatcher.hpp"
+#include "mpsc_queue.hpp"
@@ -0,0 +1,147 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <memory>
+#include <thread>
+#include <cassert>
+
+#include "signal.hpp"
+#include "vigna/config.h"
+
+namespace vigna {
+
+// bounded multi-producer single-consumer ring, each cell carries a sequence number
+// telling producers and the consumer whose turn it is, so no cell is ever locked
+template <class T, class Alloc = std::allocator<T>>
+class mpsc_queue {
+    struct cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* get() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    using alloc_traits = std::allocator_traits<Alloc>;
+    using cell_alloc = typename alloc_traits::template rebind_alloc<cell>;
+    using cell_alloc_traits = std::allocator_traits<cell_alloc>;
+
+    static size_t round_up(size_t n) {
+        size_t cap = 2;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+
+    explicit mpsc_queue(size_t capacity, const Alloc& alloc = {})
+        : alloc_(alloc), mask_(round_up(capacity) - 1) {
+        cells_ = cell_alloc_traits::allocate(alloc_, mask_ + 1);
+        for (size_t i = 0; i <= mask_; ++i)
+            cell_alloc_traits::construct(alloc_, cells_ + i), cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    ~mpsc_queue() {
+        drain([](T&) {});
+        for (size_t i = 0; i <= mask_; ++i)
+            cell_alloc_traits::destroy(alloc_, cells_ + i);
+        cell_alloc_traits::deallocate(alloc_, cells_, mask_ + 1);
+    }
+
+    [[nodiscard]] Alloc get_allocator() const { return Alloc{alloc_}; }
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+    // approximate while producers are running
+    [[nodiscard]] size_t size() const {
+        auto tail = tail_.load(std::memory_order_acquire);
+        auto head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    // any thread, fails when the ring is full
+    template <class...Args>
+    bool try_push(Args&&...args) {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& c = cells_[pos & mask_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    if constexpr (std::is_aggregate_v<T>)
+                        ::new (static_cast<void*>(c.storage)) T{std::forward<Args>(args)...};
+                    else ::new (static_cast<void*>(c.storage)) T(std::forward<Args>(args)...);
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // the consumer has not freed this cell yet
+            } else pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // any thread, waits for the consumer when the ring is full
+    template <class...Args>
+    void push(Args&&...args) {
+        while (!try_push(std::forward<Args>(args)...))
+            std::this_thread::yield();
+    }
+
+    // owning thread only
+    bool try_pop(T& out) {
+        auto pos = head_.load(std::memory_order_relaxed);
+        auto& c = cells_[pos & mask_];
+        if (c.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        out = std::move(*c.get());
+        release(c, pos);
+        return true;
+    }
+
+    // owning thread only, hands over every element published so far in push order
+    template <class Fn>
+    size_t drain(Fn&& fn, size_t max = SIZE_MAX) {
+        auto pos = head_.load(std::memory_order_relaxed);
+        size_t n = 0;
+        for (; n < max; ++n, ++pos) {
+            auto& c = cells_[pos & mask_];
+            if (c.sequence.load(std::memory_order_acquire) != pos + 1) break;
+            fn(*c.get());
+            release(c, pos);
+        }
+        return n;
+    }
+
+    // owning thread only, emits every element published so far
+    template <class Delegate, class SignalAlloc>
+    size_t publish(signal<Delegate, SignalAlloc>& sig, size_t max = SIZE_MAX) {
+        return drain([&sig](T& e) { sig.emit(e); }, max);
+    }
+
+private:
+    void release(cell& c, size_t pos) {
+        c.get()->~T();
+        c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        head_.store(pos + 1, std::memory_order_release);
+    }
+
+    cell_alloc alloc_;
+    cell* cells_{};
+    size_t mask_;
+    alignas(VIGNA_CACHE_LINE) std::atomic<size_t> tail_{};
+    alignas(VIGNA_CACHE_LINE) std::atomic<size_t> head_{};
+
+};
+
+}
@@ -4,72 +4,213 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <utility>
+
 #include "delegate.hpp"
-#include "vigna/core/dense_map.hpp"
 
 namespace vigna {
 
-template <class Delegate, class Alloc = std::allocator<std::pair<const connection, Delegate>>>
+template <class Delegate, class Alloc = std::allocator<Delegate>>
 class signal;
 
 template <template<class...> class Delegate, class...Args, class Alloc>
-class signal<Delegate<Args...>, Alloc> {
+class signal<Delegate<Args...>, Alloc> final {
     using call_t = Delegate<Args...>;
     using alloc_traits = std::allocator_traits<Alloc>;
-    using conn_alloc = typename alloc_traits::template rebind_alloc<bool>;
-    using container = compressed_pair<
-        dense_map<connection, call_t,
-            std::hash<connection>,
-            std::equal_to<connection>,
-            typename alloc_traits::template rebind_alloc<std::pair<const connection, call_t>>>,
-        conn_alloc>;
+
+    static constexpr uint32_t null_slot = UINT32_MAX;
+
+    using slot_t = detail::connection_slot;
+
+    using call_container = std::vector<call_t, typename alloc_traits::template rebind_alloc<call_t>>;
+    using owner_container = std::vector<uint32_t, typename alloc_traits::template rebind_alloc<uint32_t>>;
+    using slot_container = std::vector<slot_t, typename alloc_traits::template rebind_alloc<slot_t>>;
+
+    struct block;
+    using block_alloc = typename alloc_traits::template rebind_alloc<block>;
+    using block_alloc_traits = std::allocator_traits<block_alloc>;
+
+    // the calls and their slots, on the heap so that they stay put when the signal moves; the signal owns it,
+    // connections refer to it and keep it until the last of them goes, see connection_owner. while emitting,
+    // calls are neither moved nor destroyed: released ones lose their owner and connects go to pending,
+    // both settled by the outermost emit
+    struct block final : detail::connection_owner {
+        explicit block(const Alloc& alloc)
+            : connection_owner(&release_at, &destroy), calls(alloc), owners(alloc), pending(alloc), pending_owners(alloc), slots(alloc) {}
+
+        static void release_at(connection_owner* self, uint32_t i) { static_cast<block*>(self)->drop(i); }
+
+        static void destroy(connection_owner* self) {
+            auto* b = static_cast<block*>(self);
+            block_alloc alloc{b->calls.get_allocator()};
+            block_alloc_traits::destroy(alloc, b);
+            block_alloc_traits::deallocate(alloc, b, 1);
+        }
+
+        // connections read the slots through connection_owner
+        void sync_slots() {
+            slot_data = slots.data();
+            slot_count = slots.size();
+        }
+
+        uint32_t& owner_at(size_t i) { return i < calls.size() ? owners[i] : pending_owners[i - calls.size()]; }
+
+        void drop(size_t i) {
+            auto& owner = owner_at(i);
+            auto& slot = slots[owner];
+            ++slot.version;
+            slot.index = std::exchange(free, owner);
+            owner = null_slot;
+            if (emitting > 0) ++dead;
+            else erase_at(i);
+        }
+
+        void erase_at(size_t i) {
+            if (i != calls.size() - 1) {
+                calls[i] = std::move(calls.back());
+                owners[i] = owners.back();
+                if (owners[i] != null_slot) slots[owners[i]].index = static_cast<uint32_t>(i);
+            }
+            calls.pop_back();
+            owners.pop_back();
+        }
+
+        // pending calls join first, their slots already point past the end
+        void sweep() {
+            for (size_t k = 0; k < pending.size(); ++k) {
+                calls.push_back(std::move(pending[k]));
+                owners.push_back(pending_owners[k]);
+            }
+            pending.clear();
+            pending_owners.clear();
+            for (size_t i = calls.size(); dead > 0 && i-- > 0;)
+                if (owners[i] == null_slot) erase_at(i), --dead;
+            dead = 0;
+        }
+
+        void clear() {
+            for (size_t i = calls.size() + pending.size(); i-- > 0;)
+                if (owner_at(i) != null_slot) drop(i);
+        }
+
+        [[nodiscard]] size_t size() const { return calls.size() + pending.size() - dead; }
+
+        call_container calls;
+        owner_container owners;
+        call_container pending;
+        owner_container pending_owners;
+        slot_container slots;
+        uint32_t free{null_slot};
+        uint32_t emitting{};
+        uint32_t dead{};
+    };
+
+    block& get_block() {
+        if (!block_) {
+            block_alloc alloc{alloc_};
+            auto* b = block_alloc_traits::allocate(alloc, 1);
+            block_alloc_traits::construct(alloc, b, alloc_);
+            block_ = b;
+        }
+        return *block_;
+    }
+
+    // connections left behind turn false, the block goes with the last of them
+    static void let_go(block* b) {
+        b->clear();
+        b->abandon();
+    }
+
+    template <class Fill>
+    connection push(Fill&& fill) {
+        auto& b = get_block();
+        uint32_t index = b.free;
+        if (index != null_slot) b.free = b.slots[index].index;
+        else index = static_cast<uint32_t>(b.slots.size()), b.slots.push_back({}), b.sync_slots();
+        auto& slot = b.slots[index];
+        slot.index = static_cast<uint32_t>(b.calls.size() + b.pending.size());
+        auto& calls = b.emitting > 0 ? b.pending : b.calls;
+        (b.emitting > 0 ? b.pending_owners : b.owners).push_back(index);
+        fill(calls.emplace_back());
+        return connection{block_, index, slot.version};
+    }
 
 public:
     signal() = default;
+    explicit signal(const Alloc& alloc) : alloc_(alloc) {}
+
+    signal(const signal&) = delete;
+    signal& operator=(const signal&) = delete;
+    signal(signal&& other) noexcept : alloc_(other.alloc_), block_(std::exchange(other.block_, nullptr)) {}
+    signal& operator=(signal&& other) noexcept {
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) alloc_ = other.alloc_;
+        take(other);
+        return *this;
+    }
+
+    // connections left behind turn false
+    ~signal() { if (block_) let_go(block_); }
+
+    [[nodiscard]] Alloc get_allocator() const { return alloc_; }
 
-    [[nodiscard]] size_t size() const { return calls_.first().size(); }
-    [[nodiscard]] bool empty() const { return calls_.first().empty(); }
+    [[nodiscard]] size_t size() const { return block_ ? block_->size() : 0; }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    // heap bytes of the listeners and their slots
+    [[nodiscard]] size_t memory_size() const {
+        if (!block_) return 0;
+        return sizeof(block) + (block_->calls.capacity() + block_->pending.capacity()) * sizeof(call_t)
+            + (block_->owners.capacity() + block_->pending_owners.capacity()) * sizeof(uint32_t)
+            + block_->slots.capacity() * sizeof(slot_t);
+    }
 
     template<class Fn, class = std::enable_if_t<std::is_constructible_v<call_t, Fn>>>
     connection connect(Fn&& fn) {
-        call_t call{calls_.second(), std::forward<Fn>(fn)};
-        auto conn = call.get_connection();
-        calls_.first().emplace(conn, std::move(call));
-        return conn;
+        return push([&](call_t& call) { call.connect(std::forward<Fn>(fn)); });
     }
 
     template<auto Fn, class...Args_, class = std::enable_if_t<
         std::is_member_function_pointer_v<decltype(Fn)> ||
         std::is_invocable_v<decltype(Fn), Args_..., Args...>>>
     connection connect(Args_&&...obj_or_none) {
-        call_t call{calls_.second()};
-        auto conn = call.template connect<Fn>(std::forward<Args_>(obj_or_none)...);
-        calls_.first().emplace(conn, std::move(call));
-        return conn;
+        return push([&](call_t& call) { call.template connect<Fn>(std::forward<Args_>(obj_or_none)...); });
     }
 
     void disconnect(const connection& conn) {
         conn.release();
-        calls_.first().erase(conn);
     }
 
     void clear() {
-        for (auto&& [conn, _] : calls_.first())
-            conn.release();
-        calls_.first().clear();
+        if (block_) block_->clear();
+    }
+
+    // the listeners of other move here with their connections, those of this signal are dropped;
+    // the block stays where it is, so the allocators have to compare equal
+    void take(signal& other) {
+        assert(alloc_ == other.alloc_ && "Listeners moved between allocators");
+        if (this == &other) return;
+        if (block_) let_go(block_);
+        block_ = std::exchange(other.block_, nullptr);
     }
 
+    // listeners connected during the emit are called from the next one on
     void emit(Args...args) {
-        for (auto it = calls_.first().begin(); it != calls_.first().end();)
-            switch (it->second(std::forward<Args>(args)...)) {
-                default:
-                case signal_r::keep: ++it; break;
-                case signal_r::erase: calls_.first().erase(it); break;
-            }
+        if (!block_) return;
+        auto& b = *block_;
+        b.acquire(); // a listener may destroy the signal
+        ++b.emitting;
+        for (size_t i = 0, n = b.calls.size(); i < n; ++i)
+            if (b.owners[i] != null_slot && b.calls[i](std::forward<Args>(args)...) == signal_r::erase && b.owners[i] != null_slot)
+                b.drop(i);
+        if (--b.emitting == 0 && (b.dead > 0 || !b.pending.empty())) b.sweep();
+        b.unref();
     }
 
 private:
-     container calls_;
+    Alloc alloc_;
+    block* block_{};
 
 };
 
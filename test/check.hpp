@@ -0,0 +1,11 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// assert that stays in release builds
+#define CHECK(...) ((__VA_ARGS__) ? (void)0 : (std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #__VA_ARGS__), std::abort()))
@@ -0,0 +1,78 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+using namespace vigna;
+
+struct position { float x, y; };
+struct velocity { float dx; };
+
+// readers walk snapshots on their own threads while the registry keeps being written,
+// every snapshot has to stay the frame it was taken at: all y equal
+int main() {
+    registry reg;
+    std::vector<entity> all;
+    for (int i = 0; i < 2000; ++i) {
+        auto e = reg.create();
+        all.push_back(e);
+        reg.emplace<position>(e, position{float(i), 0});
+        reg.emplace<velocity>(e, velocity{1});
+    }
+
+    // unchanged pools are shared, a write copies only the pool written
+    auto before = reg.snapshot();
+    reg.patch<position>(all[3], [](auto&& p) { p.x = -5; });
+    auto after = reg.snapshot();
+    CHECK(&before.get<velocity>(all[3]) == &after.get<velocity>(all[3]));
+    CHECK(before.get<position>(all[3]).x == 3 && after.get<position>(all[3]).x == -5);
+
+    std::mutex mutex;
+    auto latest = reg.snapshot();
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> bad{}, reads{};
+
+    auto reader = [&] {
+        while (!stop.load() || reads.load() == 0) {
+            auto snap = [&] { std::lock_guard lock{mutex}; return latest; }();
+            bool first = true;
+            float y = 0;
+            auto v = snap.view<position, velocity>();
+            v.for_each([&](entity, const position& p, const velocity&) {
+                if (first) y = p.y, first = false;
+                else if (p.y != y) bad.fetch_add(1);
+            });
+            reads.fetch_add(1);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; ++i) threads.emplace_back(reader);
+
+    for (int frame = 0; frame < 100; ++frame) {
+        auto v = reg.view<position>();
+        for (auto [e, p] : v.each()) p.y += 1;
+        if (frame % 3 == 0) {
+            auto e = reg.create();
+            reg.emplace<position>(e, position{});
+            reg.emplace<velocity>(e, velocity{});
+            reg.destroy(e);
+        }
+        auto next = reg.snapshot();
+        std::lock_guard lock{mutex};
+        latest = std::move(next);
+    }
+    stop.store(true);
+    for (auto& t : threads) t.join();
+
+    CHECK(bad.load() == 0 && reads.load() > 0);
+    CHECK(latest.get<position>(all[7]).y == 100 && latest.valid(all[7]));
+    return 0;
+}
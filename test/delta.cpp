@@ -0,0 +1,116 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+using namespace vigna;
+
+struct position { float x, y; };
+struct frozen {};
+
+static bool same(const registry& a, const registry& b, const std::vector<entity>& all) {
+    for (auto e : all) {
+        if (a.valid(e) != b.valid(e)) return false;
+        if (!a.valid(e)) continue;
+        if (a.all_of<position>(e) != b.all_of<position>(e) || a.all_of<frozen>(e) != b.all_of<frozen>(e)) return false;
+        if (a.all_of<position>(e) && a.get<position>(e).x != b.get<position>(e).x) return false;
+    }
+    return true;
+}
+
+template <class Fn>
+static bool throws(Fn&& fn) {
+    try {
+        fn();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+static std::string record(basic_delta_recorder<registry, position, frozen>& rec) {
+    std::stringstream out;
+    stream_output_archive o{out};
+    rec.write(o);
+    rec.mark();
+    return out.str();
+}
+
+static void load(registry& dst, const std::string& delta) {
+    std::istringstream is{delta};
+    stream_input_archive i{is};
+    basic_delta_loader{dst}.apply<position, frozen>(i);
+}
+
+int main() {
+    registry src;
+    std::vector<entity> all;
+    for (int i = 0; i < 500; ++i) {
+        auto e = src.create();
+        all.push_back(e);
+        src.emplace<position>(e, position{float(i), 0});
+        if (i % 3 == 0) src.emplace<frozen>(e);
+    }
+    auto dst = src.clone();
+    basic_delta_recorder<registry, position, frozen> rec{src};
+
+    // a few frames of every kind of change, each delta brings the copy along
+    std::string first;
+    for (int frame = 0; frame < 4; ++frame) {
+        for (int i = frame; i < 500; i += 7) {
+            auto e = all[i];
+            if (!src.valid(e)) continue;
+            switch (i % 5) {
+            case 0: src.destroy(e); break;
+            case 1: src.remove<frozen>(e); break;
+            case 2: src.patch<position>(e, [](auto&& p) { p.x += 1; }); break;
+            // written through a reference, no signal fired
+            case 3: src.get<position>(e).x = -float(i); break;
+            case 4: if (!src.all_of<frozen>(e)) src.emplace<frozen>(e); break;
+            }
+        }
+        all.push_back(src.create());
+        src.emplace<position>(all.back(), position{float(frame), 1});
+
+        auto delta = record(rec);
+        if (frame == 0) first = delta;
+        load(dst, delta);
+        CHECK(same(src, dst, all));
+    }
+
+    // nothing changed, nothing to do
+    load(dst, record(rec));
+    CHECK(same(src, dst, all));
+
+    // a delta cut anywhere throws and never reads past its end
+    auto base = dst.clone();
+    src.destroy(all[1]);
+    src.patch<position>(all[2], [](auto&& p) { p.y = 7; });
+    auto delta = record(rec);
+    for (size_t len = 0; len < delta.size(); ++len) {
+        auto copy = base.clone();
+        CHECK(throws([&] { load(copy, delta.substr(0, len)); }));
+    }
+
+    // read with the types in another order
+    {
+        auto copy = base.clone();
+        std::istringstream is{delta};
+        stream_input_archive i{is};
+        CHECK(throws([&] { basic_delta_loader{copy}.apply<frozen, position>(i); }));
+    }
+
+    // applied to a registry that is not the state it was recorded from
+    {
+        registry other;
+        CHECK(throws([&] { load(other, first); }));
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <stdexcept>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+using namespace vigna;
+
+struct position { float x, y; };
+struct frozen {};
+
+using mapped_registry = basic_mapped_registry<registry>;
+
+static void write(const std::string& path, const std::string& data) {
+    std::ofstream file{path, std::ios::binary};
+    file.write(data.data(), data.size());
+}
+
+// opens the file and touches everything in it, true if that threw
+static bool rejects(const std::string& path, const std::vector<entity>& all) {
+    try {
+        mapped_registry m{path.c_str(), map_mode::read_only};
+        auto p = m.storage<position>();
+        auto f = m.storage<frozen>();
+        float sum = 0;
+        for (auto [e, v] : p.each()) sum += v.x;
+        for (auto e : all) {
+            sum += m.valid(e) + f.contains(e);
+            if (p.contains(e)) sum += p.get(e).y;
+        }
+        (void)sum;
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    const auto path = (std::filesystem::temp_directory_path() / "vigna_mapped_test.bin").string();
+
+    registry src;
+    std::vector<entity> all;
+    for (int i = 0; i < 5000; ++i) {
+        auto e = src.create();
+        all.push_back(e);
+        src.emplace<position>(e, position{float(i), 1});
+        if (i % 3 == 0) src.emplace<frozen>(e);
+    }
+    for (int i = 0; i < 50; ++i) src.destroy(all[i * 7]);
+
+    {
+        std::ofstream file{path, std::ios::binary};
+        stream_output_archive ar{file};
+        basic_mapped_snapshot{src}.entities(ar).get<position>(ar).get<frozen>(ar);
+    }
+
+    // round trip, read in place
+    {
+        mapped_registry m{path.c_str()};
+        auto p = m.storage<position>();
+        auto f = m.storage<frozen>();
+        CHECK(m.alive() == all.size() - 50 && p.size() == src.view<position>().get<position>()->size());
+        for (auto e : all) {
+            CHECK(m.valid(e) == src.valid(e));
+            if (!src.valid(e)) continue;
+            CHECK(p.contains(e) == src.all_of<position>(e) && f.contains(e) == src.all_of<frozen>(e));
+            if (p.contains(e)) CHECK(p.get(e).x == src.get<position>(e).x);
+        }
+        size_t n = 0;
+        for (auto [e, v] : p.each()) n += v.x == src.get<position>(e).x;
+        CHECK(n == p.size());
+        size_t both = 0, expected = 0;
+        m.view<position, frozen>().for_each([&](auto&&...) { ++both; });
+        src.view<position, frozen>().for_each([&](auto&&...) { ++expected; });
+        CHECK(both == expected);
+        // no pool for a type never written
+        CHECK(m.storage<float>().size() == 0);
+
+        // copy on write stays in memory, the file is left alone
+        p.get(all[1]).x = 42;
+        CHECK(m.get<position>(all[1]).x == 42);
+        mapped_registry again{path.c_str(), map_mode::read_only};
+        CHECK(again.get<position>(all[1]).x == 1);
+    }
+
+    std::string full;
+    {
+        std::ifstream file{path, std::ios::binary};
+        full.assign(std::istreambuf_iterator<char>{file}, {});
+    }
+    const auto bad_path = path + ".bad";
+
+    // a file cut anywhere is found out, never read past
+    for (size_t len = 1; len < full.size(); len += 97) {
+        write(bad_path, full.substr(0, len));
+        CHECK(rejects(bad_path, all));
+    }
+
+    // the magic and nothing after it
+    {
+        std::string zeros(4096, '\0');
+        std::memcpy(zeros.data(), &detail::mapped_magic, sizeof(detail::mapped_magic));
+        write(bad_path, zeros);
+        CHECK(rejects(bad_path, all));
+    }
+
+    // scrambled headers either throw or read inside the file, which the sanitizers watch
+    std::mt19937 gen{1};
+    for (int k = 0; k < 100; ++k) {
+        auto bad = full;
+        for (int j = 0; j < 4; ++j) bad[gen() % 512] = char(gen());
+        write(bad_path, bad);
+        rejects(bad_path, all);
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(bad_path);
+    return 0;
+}
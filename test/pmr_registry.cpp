@@ -0,0 +1,55 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <memory_resource>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+// a registry over std::pmr has to build and run through every path that moves pools or signals around,
+// polymorphic_allocator cannot be assigned
+using registry = vigna::basic_registry<vigna::entity, std::pmr::polymorphic_allocator<vigna::entity>>;
+
+struct position { float x, y; };
+struct frozen {};
+
+int main() {
+    std::pmr::unsynchronized_pool_resource resource{std::pmr::new_delete_resource()};
+    // everything has to come from resource, copies of pools included
+    std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    registry reg{&resource};
+
+    int constructed = 0;
+    auto conn = reg.on_construct<position>().connect([&](registry&, vigna::entity) { ++constructed; });
+
+    auto e = reg.create();
+    reg.emplace<position>(e, position{1, 2});
+    reg.emplace<frozen>(e);
+    CHECK(constructed == 1);
+
+    // the first write after a snapshot copies the pool, the listeners follow the copy
+    auto snap = reg.snapshot();
+    reg.patch<position>(e, [](auto&& p) { p.x = 3; });
+    CHECK(snap.get<position>(e).x == 1 && reg.get<position>(e).x == 3);
+    reg.emplace<position>(reg.create(), position{});
+    CHECK(constructed == 2 && conn);
+
+    auto copy = reg.clone();
+    CHECK(copy.get<position>(e).x == 3 && copy.all_of<frozen>(e));
+
+    registry moved{std::move(copy)};
+    CHECK(moved.valid(e) && moved.get<position>(e).x == 3);
+    // the registry moved from starts over, empty
+    CHECK(!copy.valid(e));
+    auto f = copy.create();
+    copy.emplace<position>(f, position{5, 6});
+    CHECK(copy.get<position>(f).y == 6 && moved.get<position>(e).x == 3);
+
+    reg.destroy(e);
+    CHECK(!reg.valid(e) && moved.valid(e));
+    conn.release();
+    CHECK(!conn);
+    return 0;
+}
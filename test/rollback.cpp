@@ -0,0 +1,96 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <deque>
+#include <random>
+#include <optional>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+using namespace vigna;
+
+struct position { float x, y, z; };
+struct frozen {};
+
+static std::vector<entity> all;
+
+static bool same(const registry& a, const registry& b) {
+    for (auto e : all) {
+        if (a.valid(e) != b.valid(e)) return false;
+        if (!a.valid(e)) continue;
+        if (a.all_of<position>(e) != b.all_of<position>(e) || a.all_of<frozen>(e) != b.all_of<frozen>(e)) return false;
+        if (a.all_of<position>(e)) {
+            auto& p = a.get<position>(e);
+            auto& q = b.get<position>(e);
+            if (p.x != q.x || p.y != q.y || p.z != q.z) return false;
+        }
+    }
+    // and no more in the pool than those
+    size_t na = 0, nb = 0;
+    const auto va = a.view<position>();
+    const auto vb = b.view<position>();
+    for (auto e : va) (void)e, ++na;
+    for (auto e : vb) (void)e, ++nb;
+    return na == nb;
+}
+
+// random changes of every kind between saves, each restore compared against a clone taken at the save
+int main() {
+    std::mt19937 gen{7};
+    registry reg;
+    for (int i = 0; i < 1000; ++i) {
+        auto e = reg.create();
+        all.push_back(e);
+        reg.emplace<position>(e, position{float(i), 0, 0});
+        if (i % 3 == 0) reg.emplace<frozen>(e);
+    }
+
+    basic_rollback<registry, position, frozen> rb{reg, 6};
+    std::deque<registry> saved;
+    saved.push_back(reg.clone());
+    std::optional<basic_registry_snapshot<registry>> snap;
+    size_t restores = 0;
+
+    for (int frame = 0; frame < 300; ++frame) {
+        for (int k = gen() % 100; k > 0; --k) {
+            auto e = all[gen() % all.size()];
+            switch (gen() % 10) {
+            case 0: all.push_back(reg.create()); break;
+            case 1: if (reg.valid(e)) reg.destroy(e); break;
+            case 2: if (reg.valid(e)) reg.emplace_or_replace<position>(e, position{float(gen() % 100), 1, 2}); break;
+            case 3: if (reg.valid(e) && reg.all_of<position>(e)) reg.remove<position>(e); break;
+            case 4: if (reg.valid(e) && !reg.all_of<frozen>(e)) reg.emplace<frozen>(e); break;
+            case 5: if (reg.valid(e) && reg.all_of<frozen>(e)) reg.remove<frozen>(e); break;
+            case 6: if (reg.valid(e) && reg.all_of<position>(e)) reg.patch<position>(e, [](auto&& p) { p.y += 1; }); break;
+            // written through references
+            case 7: {
+                auto v = reg.view<position>();
+                for (auto x : v) if (gen() % 300 == 0) v.get<position>(x).z += 3;
+                break;
+            }
+            case 8:
+                if (gen() % 20 == 0)
+                    reg.view<position>().get<position>()->sort([](auto&& a, auto&& b) { return a.x < b.x; });
+                break;
+            // a snapshot held across saves makes the writes copy the pools
+            case 9: if (gen() % 30 == 0) snap.emplace(reg.snapshot()); else if (gen() % 10 == 0) snap.reset(); break;
+            }
+        }
+        if (gen() % 4) {
+            rb.save();
+            saved.push_back(reg.clone());
+            if (saved.size() > 7) saved.pop_front();
+        } else {
+            size_t n = gen() % (rb.size() + 1);
+            rb.restore(n);
+            for (size_t i = 0; i < n; ++i) saved.pop_back();
+            CHECK(same(reg, saved.back()));
+            ++restores;
+        }
+    }
+    CHECK(restores > 0);
+    return 0;
+}
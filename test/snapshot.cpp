@@ -0,0 +1,122 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+using namespace vigna;
+
+struct position { float x, y; };
+struct frozen {};
+
+static std::vector<entity> fill(registry& reg) {
+    std::vector<entity> all;
+    for (int i = 0; i < 300; ++i) {
+        auto e = reg.create();
+        all.push_back(e);
+        reg.emplace<position>(e, position{float(i), 1});
+        if (i % 3 == 0) reg.emplace<frozen>(e);
+    }
+    reg.destroy(all[5]);
+    reg.destroy(all[120]);
+    return all;
+}
+
+static bool same(const registry& a, const registry& b, const std::vector<entity>& all) {
+    for (auto e : all) {
+        if (a.valid(e) != b.valid(e)) return false;
+        if (!a.valid(e)) continue;
+        if (a.all_of<position>(e) != b.all_of<position>(e) || a.all_of<frozen>(e) != b.all_of<frozen>(e)) return false;
+        if (a.all_of<position>(e) && a.get<position>(e).x != b.get<position>(e).x) return false;
+    }
+    return true;
+}
+
+template <class Fn>
+static bool throws(Fn&& fn) {
+    try {
+        fn();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    registry src;
+    auto all = fill(src);
+
+    std::stringstream out;
+    stream_output_archive o{out};
+    basic_snapshot{src}.entities(o).get<position>(o).get<frozen>(o);
+    const auto full = out.str();
+
+    // round trip, the dead entities included
+    {
+        registry dst;
+        std::istringstream is{full};
+        stream_input_archive i{is};
+        basic_snapshot_loader{dst}.entities(i).get<position>(i).get<frozen>(i);
+        CHECK(same(src, dst, all));
+        // recycled ids come back with the next version
+        auto e = dst.create();
+        CHECK(e == src.create());
+        src.destroy(e);
+    }
+
+    // the async snapshot writes the state at the time of write, whatever comes after
+    {
+        auto copy = src.clone();
+        basic_async_snapshot<registry, stream_output_archive> snap{src};
+        snap.entities().get<position>().get<frozen>();
+        std::stringstream async_out;
+        bool done = false;
+        auto fut = snap.write(stream_output_archive{async_out}, [&] { done = true; });
+        for (int i = 0; i < 50; ++i) {
+            src.patch<position>(all[i + 10], [](auto&& p) { p.x = -1; });
+            src.destroy(all[i + 200]);
+        }
+        fut.get();
+        CHECK(done);
+
+        registry dst;
+        std::istringstream is{async_out.str()};
+        stream_input_archive i{is};
+        basic_snapshot_loader{dst}.entities(i).get<position>(i).get<frozen>(i);
+        CHECK(same(copy, dst, all) && !same(src, dst, all));
+    }
+
+    // an archive cut anywhere throws and never reads past its end
+    for (size_t len = 0; len < full.size(); len += 5) {
+        registry dst;
+        std::istringstream is{full.substr(0, len)};
+        stream_input_archive i{is};
+        CHECK(throws([&] { basic_snapshot_loader{dst}.entities(i).get<position>(i).get<frozen>(i); }));
+    }
+
+    // sizes that cannot be
+    for (auto [at, value] : {std::pair<size_t, uint64_t>{0, 1000}, {8, ~uint64_t{} >> 8}}) {
+        auto bad = full;
+        std::memcpy(bad.data() + at, &value, sizeof(value));
+        registry dst;
+        std::istringstream is{bad};
+        stream_input_archive i{is};
+        CHECK(throws([&] { basic_snapshot_loader{dst}.entities(i); }));
+    }
+
+    // pools read in another order than written
+    {
+        registry dst;
+        std::istringstream is{full};
+        stream_input_archive i{is};
+        CHECK(throws([&] { basic_snapshot_loader{dst}.entities(i).get<frozen>(i); }));
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+//
+// Created by Ninter6 on 2026/10/18.
+//
+
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+
+#include <vigna.hpp>
+
+#include "check.hpp"
+
+int main() {
+    vigna::thread_pool pool{3};
+
+    // every index once
+    std::vector<std::atomic<int>> hits(10000);
+    pool.run(hits.size(), [&](size_t i) { hits[i].fetch_add(1, std::memory_order_relaxed); });
+    for (auto&& i : hits) CHECK(i.load() == 1);
+
+    // a throw on any thread, the caller's included, comes back out of run once nothing runs anymore,
+    // and the pool is still good for the next job
+    for (size_t thrower : {size_t{0}, size_t{1}, size_t{500}, size_t{9999}}) {
+        std::atomic<size_t> ran{};
+        bool caught = false;
+        try {
+            pool.run(10000, [&](size_t i) {
+                ran.fetch_add(1, std::memory_order_relaxed);
+                if (i == thrower) throw std::runtime_error("thrown");
+            });
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        CHECK(caught && ran.load() <= 10000);
+    }
+
+    // several throwing at once, one of them is rethrown
+    bool caught = false;
+    try {
+        pool.run(64, [](size_t i) { if (i % 2) throw std::logic_error("odd"); });
+    } catch (const std::logic_error&) {
+        caught = true;
+    }
+    CHECK(caught);
+
+    std::atomic<size_t> sum{};
+    pool.run(100, [&](size_t i) { sum.fetch_add(i, std::memory_order_relaxed); });
+    CHECK(sum.load() == 4950);
+    return 0;
+}